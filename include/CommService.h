@@ -22,6 +22,16 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 /// and passes the value from the key-value pair as an argument.
 /// This template defines and registers two such callbacks in this file.
 ///
+/// Handlers can also be registered under a destination key (e.g. "PMCMessage").
+/// processClientData() with no filter then routes each destination's object
+/// to its own registry, so devices sharing a connection parse each message once.
+///
+/// Besides scalars, a handler can take a whole JSON array of numbers, either as
+/// a MessageSpan<int/float/double> or as a fixed-length vectorX<T, N>, so a
+/// batched command (e.g. every actuator position) is one key and one call.
+/// Commands that are really records (e.g. MoveType + SetTip + SetTilt) can be
+/// registered as a struct schema and delivered together in one callback.
+///
 
 #pragma once
 #include "LFAST_Device.h"
@@ -34,7 +44,13 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #include <vector>
 #include <unordered_map>
 #include <cstring>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
 #include "teensy41_device.h"
+#include "JsonArena.h"
+#include "FrameCapture.h"
+#include "math_util.h"
 
 #define MAX_ARGS 4
 #define RX_BUFF_SIZE 1024
@@ -44,13 +60,43 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #define JSON_MAX_ARRAY_ITEM_SIZE JSON_OBJECT_SIZE(10)
 
 #define MAX_CTRL_MESSAGES 0x40U // can be increased if needed
+#define MAX_ARRAY_HANDLER_LEN 32 // longest JSON array an array/vector handler will accept
+
+// Message size classes. Received frames get the smallest class whose input
+// buffer fits them; replies can pick a class to suit what they carry.
+// Strings are parsed in place, so each pool only has to hold the value slots
+// (a 96 byte frame can't carry many more than 16 key/value pairs).
+#ifndef SMALL_MSG_BUFF_SIZE
+#define SMALL_MSG_BUFF_SIZE 96
+#endif
+#ifndef SMALL_MSG_DOC_SIZE
+#define SMALL_MSG_DOC_SIZE JSON_OBJECT_SIZE(16)
+#endif
+#define MEDIUM_MSG_BUFF_SIZE JSON_PROGMEM_SIZE
+#define MEDIUM_MSG_DOC_SIZE JSON_PROGMEM_SIZE
+#ifndef LARGE_MSG_BUFF_SIZE
+#define LARGE_MSG_BUFF_SIZE RX_BUFF_SIZE
+#endif
+#ifndef LARGE_MSG_DOC_SIZE
+#define LARGE_MSG_DOC_SIZE 4096
+#endif
+
+// Optional integer a client can attach to a request; replies to it carry the same value
+#define CORRELATION_ID_KEY "CorrelationId"
+// Reserved key; any message holding it gets a CommsStats reply instead of a handler call
+#define COMMS_STATS_KEY "GetCommsStats"
 
 enum COMMS_SERVICE_INFO_ROWS
 {
     COMMS_SERVICE_STATUS_ROW,
     RAW_MESSAGE_RECEIVED_ROW,
     PROCESSED_MESSAGE_ROW,
-    MESSAGE_SENT_ROW
+    MESSAGE_SENT_ROW,
+    COMMS_TRAFFIC_ROW,
+    COMMS_ERRORS_ROW,
+    COMMS_QUEUE_PEAK_ROW,
+    COMMS_DOC_PEAK_ROW,
+    NUM_COMMS_SERVICE_ROWS
     //     // PROMPT_ROW,
     //     // PROMPT_FEEDBACK,
     // #if PRINT_SERVICE_COUNTER
@@ -66,25 +112,36 @@ namespace LFAST
         ARRAY_MESSAGE,
         OBJECT_MESSAGE
     };
+    enum MESSAGE_SIZE_CLASS
+    {
+        SMALL_MESSAGE_CLASS,
+        MEDIUM_MESSAGE_CLASS,
+        LARGE_MESSAGE_CLASS,
+        NUM_MESSAGE_CLASSES
+    };
     ///////////////// TYPES /////////////////
-    class CommsMessage
+    /// @brief Storage-independent part of a message
+    ///
+    /// The JSON pool and input buffer live in SizedCommsMessage, so queues and
+    /// handlers work with CommsMessageBase and never see a message's capacity.
+    class CommsMessageBase
     {
     public:
-        CommsMessage()
-            : JsonDoc(DynamicJsonDocument(JSON_PROGMEM_SIZE))
-        {
-            std::memset(this->jsonInputBuffer, 0, sizeof(this->jsonInputBuffer));
-            processed = false;
-        }
-        virtual ~CommsMessage() {}
+        virtual ~CommsMessageBase() {}
         virtual void placeholder() {}
 
+        // Messages created with new (i.e. everything received) live in the JsonArena
+        static void *operator new(size_t sz) { return JsonArena::allocate(sz); }
+        static void operator delete(void *ptr) { JsonArena::deallocate(ptr); }
+
+        static CommsMessageBase *newForLength(size_t len);
+
         void getMessageStr(char *);
-        DynamicJsonDocument &getJsonDoc()
+        JsonDocument &getJsonDoc()
         {
             return this->JsonDoc;
         }
-        DynamicJsonDocument &deserialize(TerminalInterface *debugCli = nullptr);
+        JsonDocument &deserialize(TerminalInterface *debugCli = nullptr);
         template <typename T>
         inline T getValue(const char *key);
 
@@ -104,7 +161,12 @@ namespace LFAST
         {
             return jsonInputBuffer;
         };
-        char jsonInputBuffer[JSON_PROGMEM_SIZE];
+        /// @brief Largest payload the input buffer can hold (one byte is kept for the terminator)
+        size_t getInputCapacity()
+        {
+            return inputBufferSize - 1;
+        }
+        char *const jsonInputBuffer;
         void setProcessedFlag()
         {
             processed = true;
@@ -113,12 +175,88 @@ namespace LFAST
         {
             return processed;
         }
+        /// @brief True once the input has been parsed, which cuts it up in place
+        bool isDeserialized()
+        {
+            return deserialized;
+        }
+        /// @brief Marks the input buffer as holding a MessagePack (binary) payload of the given length
+        void setBinaryInput(size_t len)
+        {
+            msgPackFormat = true;
+            inputLength = len;
+        }
+        /// @brief Terminates a payload that was copied into jsonInputBuffer and detects its format
+        ///
+        /// Anything that doesn't start like a JSON object is treated as a MessagePack map.
+        void setInputLength(size_t len)
+        {
+            jsonInputBuffer[len] = '\0';
+            char c0 = jsonInputBuffer[0];
+            if (!(c0 == '{' || c0 == ' ' || c0 == '\r' || c0 == '\n' || c0 == '\t'))
+                setBinaryInput(len);
+            else
+                inputLength = len;
+        }
+        bool isBinary()
+        {
+            return msgPackFormat;
+        }
+        void setLatestWinsFlag()
+        {
+            latestWins = true;
+        }
+        bool isLatestWins()
+        {
+            return latestWins;
+        }
+        /// @brief True if the input couldn't be parsed (including running out of JSON pool)
+        bool parseFailed()
+        {
+            return parseError;
+        }
+        /// @brief True if something added to the message didn't fit in its JSON pool
+        bool isTruncated()
+        {
+            return truncated || JsonDoc.overflowed();
+        }
+        /// @brief Size class of the message, judged by its JSON pool capacity
+        uint8_t getSizeClass()
+        {
+            if (JsonDoc.capacity() <= SMALL_MSG_DOC_SIZE)
+                return SMALL_MESSAGE_CLASS;
+            if (JsonDoc.capacity() <= MEDIUM_MSG_DOC_SIZE)
+                return MEDIUM_MESSAGE_CLASS;
+            return LARGE_MESSAGE_CLASS;
+        }
 
         void printMessageInfo(TerminalInterface *debugCli = nullptr);
 
     protected:
-        DynamicJsonDocument JsonDoc;
+        // The derived class's members aren't constructed yet, so only their addresses are taken here
+        CommsMessageBase(JsonDocument &doc, char *inputBuff, size_t inputBuffSize)
+            : jsonInputBuffer(inputBuff), JsonDoc(doc), inputBufferSize(inputBuffSize)
+        {
+            processed = false;
+            deserialized = false;
+            msgPackFormat = false;
+            latestWins = false;
+            parseError = false;
+            truncated = false;
+            inputLength = 0;
+        }
+        CommsMessageBase(const CommsMessageBase &) = delete;
+        CommsMessageBase &operator=(const CommsMessageBase &) = delete;
+
+        JsonDocument &JsonDoc;
+        const size_t inputBufferSize;
         bool processed;
+        bool deserialized;
+        bool msgPackFormat;
+        bool latestWins;
+        bool parseError;
+        bool truncated;
+        size_t inputLength;
         JsonArray array;
         JsonObject nested;
         std::string destKey;
@@ -126,6 +264,31 @@ namespace LFAST
         size_t arrayMemUsagePrev;
     };
 
+    /// @brief Message with a fixed-capacity JSON pool and input buffer
+    /// @tparam DOC_SIZE Bytes in the StaticJsonDocument pool
+    /// @tparam BUFF_SIZE Bytes in the raw input buffer (including the terminator)
+    template <size_t DOC_SIZE, size_t BUFF_SIZE>
+    class SizedCommsMessage : public CommsMessageBase
+    {
+    public:
+        SizedCommsMessage()
+            : CommsMessageBase(doc, inputBuff, BUFF_SIZE)
+        {
+            std::memset(this->inputBuff, 0, sizeof(this->inputBuff));
+        }
+        virtual ~SizedCommsMessage() {}
+
+    private:
+        StaticJsonDocument<DOC_SIZE> doc;
+        char inputBuff[BUFF_SIZE];
+    };
+
+    typedef SizedCommsMessage<SMALL_MSG_DOC_SIZE, SMALL_MSG_BUFF_SIZE> SmallCommsMessage;
+    typedef SizedCommsMessage<MEDIUM_MSG_DOC_SIZE, MEDIUM_MSG_BUFF_SIZE> MediumCommsMessage;
+    typedef SizedCommsMessage<LARGE_MSG_DOC_SIZE, LARGE_MSG_BUFF_SIZE> LargeCommsMessage;
+    // The default message, same footprint as before messages were sized
+    typedef MediumCommsMessage CommsMessage;
+
     template <class T>
     struct MessageHandler
     {
@@ -153,25 +316,142 @@ namespace LFAST
         }
     };
 
+    /// @brief Traffic counters, kept per connection and for the whole service
+    struct CommsLinkStats
+    {
+        uint32_t bytesIn;
+        uint32_t bytesOut;
+        uint32_t framesIn;
+        uint32_t framesOut;
+        uint32_t droppedFrames;
+        uint32_t parseErrors;
+        size_t rxQueuePeak;
+    };
+
+    struct CommsStats
+    {
+        CommsLinkStats totals;
+        uint32_t truncatedMessages;
+        uint32_t coalescedValues;
+        size_t peakDocUsage[NUM_MESSAGE_CLASSES];
+    };
+
+    /// @brief Read-only view of the numbers in a JSON array value
+    ///
+    /// Handed to MessageHandler<MessageSpan<T>> handlers, e.g. {"SetPositions": [1.0, 2.0, 3.0]}.
+    /// The data is only valid for the duration of the handler call.
+    template <typename T>
+    struct MessageSpan
+    {
+        const T *data;
+        size_t len;
+
+        size_t size() const { return len; }
+        const T &operator[](size_t i) const { return data[i]; }
+        const T *begin() const { return data; }
+        const T *end() const { return data + len; }
+    };
+
     struct ClientConnection
     {
-        ClientConnection(Client *_client) : client(_client), noReplyFlag(false) {}
+        ClientConnection(Client *_client, bool _framed = false)
+            : id(nextId()), client(_client), noReplyFlag(false), framedLink(_framed), remotePort(0),
+              binaryPeer(false), rxSeqValid(false), rxSeqNo(0), txSeqNo(0), lastRxMs(0),
+              hasCorrelationId(false), correlationId(0) {}
+        ClientConnection(const IPAddress &_ip, uint16_t _port)
+            : id(nextId()), client(nullptr), noReplyFlag(false), framedLink(false), remoteIp(_ip), remotePort(_port),
+              binaryPeer(false), rxSeqValid(false), rxSeqNo(0), txSeqNo(0), lastRxMs(0),
+              hasCorrelationId(false), correlationId(0) {}
+        /// @brief Next connection id; ids count up and aren't reused until they wrap
+        static uint16_t nextId()
+        {
+            static uint16_t counter = 0;
+            // 0xFFFF is kept for frames that can't be attributed to a connection
+            if (counter == 0xFFFF)
+                counter = 0;
+            return counter++;
+        }
+        // Tags this link's frames in captures; unlike its index, it doesn't shift as links come and go
+        uint16_t id;
         Client *client;
         bool noReplyFlag;
-        std::vector<CommsMessage *> rxMessageQueue;
-        std::vector<CommsMessage *> txMessageQueue;
+        // Framed links (e.g. COBS over serial) are read by their own service, not by brace counting
+        bool framedLink;
+        std::vector<CommsMessageBase *> rxMessageQueue;
+        std::vector<CommsMessageBase *> txMessageQueue;
+
+        // Datagram peers (client == nullptr) are addressed by endpoint instead of a Client
+        bool isDatagramPeer() { return client == nullptr; }
+        IPAddress remoteIp;
+        uint16_t remotePort;
+        bool binaryPeer;
+        bool rxSeqValid;
+        uint32_t rxSeqNo;
+        uint32_t txSeqNo;
+        // millis() when the peer last sent a datagram
+        uint32_t lastRxMs;
+
+        // Correlation ID of the request currently being processed, if it had one
+        bool hasCorrelationId;
+        uint32_t correlationId;
+
+        CommsLinkStats stats{};
     };
 
-    class CommsService : public LFAST_Device
+    enum STRUCT_FIELD_TYPE
     {
+        INT_FIELD,
+        UINT_FIELD,
+        FLOAT_FIELD,
+        DOUBLE_FIELD,
+        BOOL_FIELD
+    };
 
-    protected:
-        static void defaultMessageHandler(const char *);
-        void errorMessageHandler(CommsMessage &msg);
-        static std::vector<ClientConnection> connections;
-        ClientConnection *activeConnection;
-        bool commsServiceStatus;
-        virtual void setupPersistentFields() override;
+    template <typename T>
+    constexpr uint8_t structFieldType()
+    {
+        static_assert(sizeof(T) == 0, "struct fields must be int, unsigned int, float, double or bool");
+        return 0;
+    }
+    template <>
+    constexpr uint8_t structFieldType<int>() { return INT_FIELD; }
+    template <>
+    constexpr uint8_t structFieldType<unsigned int>() { return UINT_FIELD; }
+    template <>
+    constexpr uint8_t structFieldType<float>() { return FLOAT_FIELD; }
+    template <>
+    constexpr uint8_t structFieldType<double>() { return DOUBLE_FIELD; }
+    template <>
+    constexpr uint8_t structFieldType<bool>() { return BOOL_FIELD; }
+
+    /// @brief One member of a struct schema; build these with STRUCT_FIELD()
+    struct StructField
+    {
+        const char *key;
+        size_t offset;
+        uint8_t type;
+        bool required;
+    };
+
+// e.g. STRUCT_FIELD(MoveCmd, tip, "SetTip", true)
+#define STRUCT_FIELD(S, member, key, required) \
+    LFAST::StructField { key, offsetof(S, member), LFAST::structFieldType<decltype(S::member)>(), required }
+
+#define MAX_STRUCT_FIELDS 32 // one bit per field in the presence mask
+
+    /// @brief How queued values of a key are delivered when messages back up
+    enum KEY_SEMANTICS
+    {
+        EVENT_KEY, // every value is delivered, in order (default)
+        STATE_KEY  // only the newest queued value is delivered
+    };
+
+    /// @brief Table of key -> handler function associations
+    ///
+    /// CommsService has a default registry for keys at the top level of a message
+    /// (or under a destFilter), plus one registry per routed destination key.
+    class MessageHandlerRegistry
+    {
     private:
         enum HandlerType
         {
@@ -180,8 +460,49 @@ namespace LFAST
             FLOAT_HANDLER,
             DOUBLE_HANDLER,
             BOOL_HANDLER,
-            STRING_HANDLER
+            STRING_HANDLER,
+            INT_ARRAY_HANDLER,
+            FLOAT_ARRAY_HANDLER,
+            DOUBLE_ARRAY_HANDLER,
+            VECTOR_HANDLER
+        };
+        /// @brief Type-erased vectorX handler: the thunk knows the element type and length
+        struct VectorHandler
+        {
+            void (*fn)();
+            bool (*thunk)(void (*)(), JsonArray);
         };
+        template <typename T, size_t N>
+        static bool callVectorHandler(void (*fn)(), JsonArray arr);
+        template <typename T>
+        static bool copyArray(JsonArray arr, T *dest, size_t &len);
+
+        /// @brief A registered struct schema and the record it is decoded into
+        struct StructBinding
+        {
+            std::vector<StructField> fields;
+            uint32_t requiredMask;
+            uint32_t presentMask;
+            // Owned; deleted as the S it was allocated as
+            std::unique_ptr<void, void (*)(void *)> record{nullptr, nullptr};
+            size_t recordSize;
+            void (*fn)();
+            void (*deliver)(void (*)(), const void *, uint32_t);
+        };
+        struct StructFieldRef
+        {
+            uint16_t binding;
+            uint8_t field;
+        };
+        template <typename S>
+        static void deliverStruct(void (*fn)(), const void *record, uint32_t presentMask);
+        template <typename S>
+        static void deleteRecord(void *record) { delete static_cast<S *>(record); }
+        bool isStructKey(const char *key) { return structFields.find(key) != structFields.end(); }
+        std::vector<StructBinding> structBindings;
+        std::unordered_map<std::string, StructFieldRef> structFields;
+        std::unordered_map<std::string, uint8_t> stateKeys;
+        bool storeStructField(const char *key, JsonVariant val);
         std::unordered_map<std::string, HandlerType> handlerTypes;
         std::unordered_map<std::string, MessageHandler<int>> intHandlers;
         std::unordered_map<std::string, MessageHandler<unsigned int>> uIntHandlers;
@@ -190,35 +511,107 @@ namespace LFAST
         std::unordered_map<std::string, MessageHandler<bool>> boolHandlers;
         // std::unordered_map<std::string, MessageHandler<std::string>> stringHandlers;
         std::unordered_map<std::string, MessageHandler<const char *>> stringHandlers;
+        std::unordered_map<std::string, MessageHandler<MessageSpan<int>>> intArrayHandlers;
+        std::unordered_map<std::string, MessageHandler<MessageSpan<float>>> floatArrayHandlers;
+        std::unordered_map<std::string, MessageHandler<MessageSpan<double>>> doubleArrayHandlers;
+        std::unordered_map<std::string, VectorHandler> vectorHandlers;
         template <class T>
         bool callMessageHandler(const char *key, T val);
+        template <class T>
+        bool callArrayHandler(const char *key, JsonVariant val);
+
+    public:
+        template <class T>
+        inline bool registerMessageHandler(const char *key, MessageHandler<T> fn);
+        template <typename T, size_t N>
+        inline bool registerVectorHandler(const char *key, void (*fn)(const vectorX<T, N> &));
+        template <typename S, size_t NF>
+        inline bool registerStructHandler(const StructField (&fields)[NF], void (*fn)(const S &, uint32_t));
+        bool callMessageHandler(JsonPair kvp);
+        void finishStructs();
+        void setKeySemantics(const char *key, uint8_t semantics);
+        bool hasStateKeys() { return !stateKeys.empty(); }
+        bool isStateKey(const char *key) { return stateKeys.find(key) != stateKeys.end(); }
+    };
+
+    class CommsService : public LFAST_Device
+    {
+
+    protected:
+        static void defaultMessageHandler(const char *);
+        void errorMessageHandler(CommsMessageBase &msg);
+        static std::vector<ClientConnection> connections;
+        ClientConnection *activeConnection;
+        bool commsServiceStatus;
+        void takeCorrelationId(JsonObject);
+        void stampCorrelationId(CommsMessageBase &, ClientConnection &);
+        void dispatchObject(MessageHandlerRegistry &, JsonObject);
+        virtual void setupPersistentFields() override;
+        // Indexed by COMMS_SERVICE_INFO_ROWS
+        PersistentFieldHandle infoFields[NUM_COMMS_SERVICE_ROWS];
+
+        static CommsStats commsStats;
+        void recordRx(ClientConnection *, size_t bytes, bool accepted);
+        void recordTx(ClientConnection *, CommsMessageBase &, size_t bytes);
+        void recordDocUsage(CommsMessageBase &);
+        void sendCommsStats();
+        void updateStatsFields();
+        static void commsCommand(TerminalInterface *cli, const char *args, void *context);
+        static void resetCommsStats(void *context);
+        void coalesceStateKeys(ClientConnection &, const char *destFilter);
+        static FrameCaptureWriter *captureWriter;
+        void captureFrame(ClientConnection *, const void *data, size_t len);
+        void pruneStateKeys(MessageHandlerRegistry &, const char *scope, JsonObject);
+    private:
+        MessageHandlerRegistry defaultHandlers;
+        std::unordered_map<std::string, MessageHandlerRegistry> routingTable;
+        // Scratch lists for coalesceStateKeys(), kept to avoid reallocating every tick
+        std::vector<std::pair<const char *, const char *>> seenStateKeys;
+        std::vector<const char *> staleStateKeys;
 
     public:
         CommsService();
         virtual ~CommsService() {}
 
-        void setupClientMessageBuffers(Client *client);
+        void setupClientMessageBuffers(Client *client, bool framed = false);
         bool getNewMessages(ClientConnection &);
         enum
         {
             ACTIVE_CONNECTION = 1,
             ALL_CONNECTED = 2,
         };
-        virtual void sendMessage(CommsMessage &, uint8_t);
+        virtual void sendMessage(CommsMessageBase &, uint8_t);
         template <class T>
         inline bool registerMessageHandler(const char *key, MessageHandler<T> fn);
-        inline bool callMessageHandler(JsonPair kvp);
+        template <class T>
+        inline bool registerMessageHandler(const char *destKey, const char *key, MessageHandler<T> fn);
+        template <typename T, size_t N>
+        inline bool registerVectorHandler(const char *key, void (*fn)(const vectorX<T, N> &));
+        template <typename T, size_t N>
+        inline bool registerVectorHandler(const char *destKey, const char *key, void (*fn)(const vectorX<T, N> &));
+        template <typename S, size_t NF>
+        inline bool registerStructHandler(const StructField (&fields)[NF], void (*fn)(const S &, uint32_t));
+        template <typename S, size_t NF>
+        inline bool registerStructHandler(const char *destKey, const StructField (&fields)[NF], void (*fn)(const S &, uint32_t));
+        MessageHandlerRegistry &getRoute(const char *destKey);
+        bool callMessageHandler(JsonPair kvp);
+        void setKeySemantics(const char *key, uint8_t semantics);
+        void setKeySemantics(const char *destKey, const char *key, uint8_t semantics);
+        static const CommsStats &getCommsStats() { return commsStats; }
+        void startCapture(CaptureSink &sink);
+        void stopCapture();
+        bool isCapturing() { return captureWriter != nullptr; }
 
         virtual bool Status()
         {
             return commsServiceStatus;
         };
 
-        bool checkForNewClientData();
+        virtual bool checkForNewClientData();
         virtual bool checkForNewClients();
         virtual void stopDisconnectedClients();
-        virtual void processClientData(const char *);
-        virtual void processMessage(CommsMessage *, const char *);
+        virtual void processClientData(const char *destFilter = "");
+        virtual void processMessage(CommsMessageBase *, const char *);
         void setNoReplyFlag(bool f)
         {
             activeConnection->noReplyFlag = f;
@@ -227,7 +620,7 @@ namespace LFAST
 
     // NOTE: Teensy build environment doesn't handle build flags properly, so can't use typeid().
     // template <class T>
-    // bool LFAST::CommsService::registerMessageHandler(const char *  key, MessageHandler<T> fn)
+    // bool LFAST::MessageHandlerRegistry::registerMessageHandler(const char *  key, MessageHandler<T> fn)
     // {
     //     if (typeid(T) == typeid(int))
     //         this->intHandlers[key] = fn;
@@ -245,57 +638,224 @@ namespace LFAST
     // }
 
     template <class T>
-    bool LFAST::CommsService::registerMessageHandler(const char *key, MessageHandler<T> fn)
+    bool LFAST::MessageHandlerRegistry::registerMessageHandler(const char *key, MessageHandler<T> fn)
     {
         // TODO: Add exception handling
         return false;
     }
 
     template <>
-    inline bool LFAST::CommsService::registerMessageHandler(const char *key, MessageHandler<int> fn)
+    inline bool LFAST::MessageHandlerRegistry::registerMessageHandler(const char *key, MessageHandler<int> fn)
     {
+        if (isStructKey(key))
+            return false;
         this->intHandlers[key] = fn;
         this->handlerTypes[key] = INT_HANDLER;
         return true;
     }
     template <>
-    inline bool LFAST::CommsService::registerMessageHandler(const char *key, MessageHandler<unsigned int> fn)
+    inline bool LFAST::MessageHandlerRegistry::registerMessageHandler(const char *key, MessageHandler<unsigned int> fn)
     {
+        if (isStructKey(key))
+            return false;
         this->uIntHandlers[key] = fn;
         this->handlerTypes[key] = UINT_HANDLER;
         return true;
     }
     template <>
-    inline bool LFAST::CommsService::registerMessageHandler(const char *key, MessageHandler<float> fn)
+    inline bool LFAST::MessageHandlerRegistry::registerMessageHandler(const char *key, MessageHandler<float> fn)
     {
+        if (isStructKey(key))
+            return false;
         this->floatHandlers[key] = fn;
         this->handlerTypes[key] = FLOAT_HANDLER;
         return true;
     }
     template <>
-    inline bool LFAST::CommsService::registerMessageHandler(const char *key, MessageHandler<double> fn)
+    inline bool LFAST::MessageHandlerRegistry::registerMessageHandler(const char *key, MessageHandler<double> fn)
     {
+        if (isStructKey(key))
+            return false;
         this->doubleHandlers[key] = fn;
         this->handlerTypes[key] = DOUBLE_HANDLER;
         return true;
     }
     template <>
-    inline bool LFAST::CommsService::registerMessageHandler(const char *key, MessageHandler<bool> fn)
+    inline bool LFAST::MessageHandlerRegistry::registerMessageHandler(const char *key, MessageHandler<bool> fn)
     {
+        if (isStructKey(key))
+            return false;
         this->boolHandlers[key] = fn;
         this->handlerTypes[key] = BOOL_HANDLER;
         return true;
     }
 
     template <>
-    inline bool LFAST::CommsService::registerMessageHandler(const char *key, MessageHandler<const char *> fn)
+    inline bool LFAST::MessageHandlerRegistry::registerMessageHandler(const char *key, MessageHandler<const char *> fn)
     {
+        if (isStructKey(key))
+            return false;
         this->stringHandlers[key] = fn;
         this->handlerTypes[key] = STRING_HANDLER;
         return true;
     }
     template <>
-    inline bool LFAST::CommsService::callMessageHandler(const char *key, int val)
+    inline bool LFAST::MessageHandlerRegistry::registerMessageHandler(const char *key, MessageHandler<MessageSpan<int>> fn)
+    {
+        if (isStructKey(key))
+            return false;
+        this->intArrayHandlers[key] = fn;
+        this->handlerTypes[key] = INT_ARRAY_HANDLER;
+        return true;
+    }
+    template <>
+    inline bool LFAST::MessageHandlerRegistry::registerMessageHandler(const char *key, MessageHandler<MessageSpan<float>> fn)
+    {
+        if (isStructKey(key))
+            return false;
+        this->floatArrayHandlers[key] = fn;
+        this->handlerTypes[key] = FLOAT_ARRAY_HANDLER;
+        return true;
+    }
+    template <>
+    inline bool LFAST::MessageHandlerRegistry::registerMessageHandler(const char *key, MessageHandler<MessageSpan<double>> fn)
+    {
+        if (isStructKey(key))
+            return false;
+        this->doubleArrayHandlers[key] = fn;
+        this->handlerTypes[key] = DOUBLE_ARRAY_HANDLER;
+        return true;
+    }
+
+    /// @brief Registers a handler that gets a JSON array of exactly N numbers as a vectorX<T, N>
+    ///
+    /// e.g. registerVectorHandler<double, 3>("SetTipTiltPiston", fn) handles
+    /// {"SetTipTiltPiston": [0.01, -0.02, 5.0]}. Arrays of any other length are ignored.
+    template <typename T, size_t N>
+    inline bool LFAST::MessageHandlerRegistry::registerVectorHandler(const char *key, void (*fn)(const vectorX<T, N> &))
+    {
+        static_assert(N <= MAX_ARRAY_HANDLER_LEN, "vector handler longer than MAX_ARRAY_HANDLER_LEN");
+        if (isStructKey(key))
+            return false;
+        this->vectorHandlers[key] = VectorHandler{reinterpret_cast<void (*)()>(fn), &callVectorHandler<T, N>};
+        this->handlerTypes[key] = VECTOR_HANDLER;
+        return true;
+    }
+
+    /// @brief Registers a struct schema; messages holding its keys are decoded into one S
+    ///
+    /// Every key of the schema found in an object (top level, destFilter or
+    /// routed destination) is written straight into the record during the normal
+    /// pass over that object. Once the object is done, fn gets the record and a
+    /// mask with bit i set if fields[i] was present, as long as every required
+    /// field was. Fields that weren't sent are zero.
+    ///
+    /// A key belongs to one handler: the schema is refused if any of its keys
+    /// repeats, is in an earlier schema or already has a message handler, and
+    /// message handlers are refused for keys a schema holds.
+    ///
+    /// @param fields Schema, e.g. { STRUCT_FIELD(MoveCmd, tip, "SetTip", true), ... }
+    /// @param fn Called as fn(record, presentMask)
+    /// @return false if a key was already taken; nothing is registered
+    template <typename S, size_t NF>
+    inline bool LFAST::MessageHandlerRegistry::registerStructHandler(const StructField (&fields)[NF], void (*fn)(const S &, uint32_t))
+    {
+        static_assert(NF <= MAX_STRUCT_FIELDS, "too many fields for the presence mask");
+        static_assert(std::is_trivially_copyable<S>::value, "struct handlers need a plain-data struct");
+
+        for (size_t ii = 0; ii < NF; ii++)
+        {
+            if (isStructKey(fields[ii].key) || this->handlerTypes.find(fields[ii].key) != this->handlerTypes.end())
+                return false;
+            for (size_t jj = 0; jj < ii; jj++)
+                if (std::strcmp(fields[ii].key, fields[jj].key) == 0)
+                    return false;
+        }
+
+        StructBinding binding;
+        binding.fields.assign(fields, fields + NF);
+        binding.requiredMask = 0;
+        binding.presentMask = 0;
+        binding.record = std::unique_ptr<void, void (*)(void *)>(new S(), &deleteRecord<S>);
+        binding.recordSize = sizeof(S);
+        binding.fn = reinterpret_cast<void (*)()>(fn);
+        binding.deliver = &deliverStruct<S>;
+
+        uint16_t bindingIdx = structBindings.size();
+        for (uint8_t ii = 0; ii < NF; ii++)
+        {
+            if (fields[ii].required)
+                binding.requiredMask |= (1UL << ii);
+            this->structFields[fields[ii].key] = StructFieldRef{bindingIdx, ii};
+        }
+        structBindings.push_back(std::move(binding));
+        return true;
+    }
+
+    template <typename S>
+    void LFAST::MessageHandlerRegistry::deliverStruct(void (*fn)(), const void *record, uint32_t presentMask)
+    {
+        reinterpret_cast<void (*)(const S &, uint32_t)>(fn)(*static_cast<const S *>(record), presentMask);
+    }
+
+    template <typename T, size_t N>
+    bool LFAST::MessageHandlerRegistry::callVectorHandler(void (*fn)(), JsonArray arr)
+    {
+        if (arr.size() != N)
+            return false;
+        vectorX<T, N> vec;
+        size_t ii = 0;
+        for (JsonVariant item : arr)
+            vec[ii++] = item.as<T>();
+        reinterpret_cast<void (*)(const vectorX<T, N> &)>(fn)(vec);
+        return true;
+    }
+
+    /// @brief Converts a JSON array into dest, which holds MAX_ARRAY_HANDLER_LEN values
+    /// @return false if the value isn't an array or is too long
+    template <typename T>
+    bool LFAST::MessageHandlerRegistry::copyArray(JsonArray arr, T *dest, size_t &len)
+    {
+        if (arr.isNull() || arr.size() > MAX_ARRAY_HANDLER_LEN)
+            return false;
+        len = 0;
+        for (JsonVariant item : arr)
+            dest[len++] = item.as<T>();
+        return true;
+    }
+
+    template <>
+    inline bool LFAST::MessageHandlerRegistry::callArrayHandler<int>(const char *key, JsonVariant val)
+    {
+        static int scratch[MAX_ARRAY_HANDLER_LEN];
+        MessageSpan<int> span{scratch, 0};
+        if (!copyArray(val.as<JsonArray>(), scratch, span.len))
+            return false;
+        return this->intArrayHandlers[key].call(span);
+    }
+
+    template <>
+    inline bool LFAST::MessageHandlerRegistry::callArrayHandler<float>(const char *key, JsonVariant val)
+    {
+        static float scratch[MAX_ARRAY_HANDLER_LEN];
+        MessageSpan<float> span{scratch, 0};
+        if (!copyArray(val.as<JsonArray>(), scratch, span.len))
+            return false;
+        return this->floatArrayHandlers[key].call(span);
+    }
+
+    template <>
+    inline bool LFAST::MessageHandlerRegistry::callArrayHandler<double>(const char *key, JsonVariant val)
+    {
+        static double scratch[MAX_ARRAY_HANDLER_LEN];
+        MessageSpan<double> span{scratch, 0};
+        if (!copyArray(val.as<JsonArray>(), scratch, span.len))
+            return false;
+        return this->doubleArrayHandlers[key].call(span);
+    }
+
+    template <>
+    inline bool LFAST::MessageHandlerRegistry::callMessageHandler(const char *key, int val)
     {
         auto mh = this->intHandlers[key];
         mh.call(val);
@@ -303,7 +863,7 @@ namespace LFAST
     }
 
     template <>
-    inline bool LFAST::CommsService::callMessageHandler(const char *key, unsigned int val)
+    inline bool LFAST::MessageHandlerRegistry::callMessageHandler(const char *key, unsigned int val)
     {
         auto mh = this->uIntHandlers[key];
         mh.call(val);
@@ -311,7 +871,7 @@ namespace LFAST
     }
 
     template <>
-    inline bool LFAST::CommsService::callMessageHandler(const char *key, float val)
+    inline bool LFAST::MessageHandlerRegistry::callMessageHandler(const char *key, float val)
     {
         auto mh = this->floatHandlers[key];
         mh.call(val);
@@ -319,7 +879,7 @@ namespace LFAST
     }
 
     template <>
-    inline bool LFAST::CommsService::callMessageHandler(const char *key, double val)
+    inline bool LFAST::MessageHandlerRegistry::callMessageHandler(const char *key, double val)
     {
         auto mh = this->doubleHandlers[key];
         mh.call(val);
@@ -327,7 +887,7 @@ namespace LFAST
     }
 
     template <>
-    inline bool LFAST::CommsService::callMessageHandler(const char *key, bool val)
+    inline bool LFAST::MessageHandlerRegistry::callMessageHandler(const char *key, bool val)
     {
         auto mh = this->boolHandlers[key];
         mh.call(val);
@@ -335,44 +895,84 @@ namespace LFAST
     }
 
     template <>
-    inline bool LFAST::CommsService::callMessageHandler(const char *key, const char *val)
+    inline bool LFAST::MessageHandlerRegistry::callMessageHandler(const char *key, const char *val)
     {
         auto mh = this->stringHandlers[key];
         mh.call(val);
         return true;
     }
 
+    template <class T>
+    inline bool LFAST::CommsService::registerMessageHandler(const char *key, MessageHandler<T> fn)
+    {
+        return defaultHandlers.registerMessageHandler<T>(key, fn);
+    }
+
+    /// @brief Registers a handler for a key inside a routed destination object
+    ///
+    /// e.g. registerMessageHandler<double>("PMCMessage", "SetTip", fn) handles
+    /// {"PMCMessage": {"SetTip": 0.01}}.
+    template <class T>
+    inline bool LFAST::CommsService::registerMessageHandler(const char *destKey, const char *key, MessageHandler<T> fn)
+    {
+        return getRoute(destKey).registerMessageHandler<T>(key, fn);
+    }
+
+    template <typename S, size_t NF>
+    inline bool LFAST::CommsService::registerStructHandler(const StructField (&fields)[NF], void (*fn)(const S &, uint32_t))
+    {
+        return defaultHandlers.registerStructHandler<S, NF>(fields, fn);
+    }
+
+    template <typename S, size_t NF>
+    inline bool LFAST::CommsService::registerStructHandler(const char *destKey, const StructField (&fields)[NF], void (*fn)(const S &, uint32_t))
+    {
+        return getRoute(destKey).registerStructHandler<S, NF>(fields, fn);
+    }
+
+    template <typename T, size_t N>
+    inline bool LFAST::CommsService::registerVectorHandler(const char *key, void (*fn)(const vectorX<T, N> &))
+    {
+        return defaultHandlers.registerVectorHandler<T, N>(key, fn);
+    }
+
+    template <typename T, size_t N>
+    inline bool LFAST::CommsService::registerVectorHandler(const char *destKey, const char *key, void (*fn)(const vectorX<T, N> &))
+    {
+        return getRoute(destKey).registerVectorHandler<T, N>(key, fn);
+    }
+
     template <>
-    inline double CommsMessage::getValue(const char *key)
+    inline double CommsMessageBase::getValue(const char *key)
     {
         return (JsonDoc[key].as<double>());
     }
 
     template <>
-    inline int CommsMessage::getValue(const char *key)
+    inline int CommsMessageBase::getValue(const char *key)
     {
         return (JsonDoc[key].as<int>());
     }
 
     template <>
-    inline unsigned int CommsMessage::getValue(const char *key)
+    inline unsigned int CommsMessageBase::getValue(const char *key)
     {
         return (JsonDoc[key].as<unsigned int>());
     }
 
     template <>
-    inline bool CommsMessage::getValue(const char *key)
+    inline bool CommsMessageBase::getValue(const char *key)
     {
         return (JsonDoc[key].as<bool>());
     }
 
     template <>
-    inline const char *CommsMessage::getValue(const char *key)
+    inline const char *CommsMessageBase::getValue(const char *key)
     {
         return (JsonDoc[key].as<const char *>());
     }
 
-    // inline void CommsMessage::addDestinationKey(const char *  key)
+    // inline void CommsMessageBase::addDestinationKey(const char *  key)
     // {
 
     //     // newDoc.createNestedObject(key);
@@ -399,7 +999,7 @@ namespace LFAST
     // }
 
     // template <typename T>
-    // inline void CommsMessage::addKeyValuePair(const char *  key, T val)
+    // inline void CommsMessageBase::addKeyValuePair(const char *  key, T val)
     // {
     //     if (this->destKey.length() > 0)
     //         JsonDoc[(this->destKey)][key] = val;
@@ -408,7 +1008,7 @@ namespace LFAST
     // };
 
     template <typename T>
-    inline void CommsMessage::addKeyValuePair(const char *key, T val)
+    inline void CommsMessageBase::addKeyValuePair(const char *key, T val)
     {
         if (this->destKey.length() > 0)
             JsonDoc[(this->destKey)][(key)] = val;
@@ -417,7 +1017,7 @@ namespace LFAST
     }
 
     template <typename T>
-    inline void CommsMessage::addKeyValuePairToArray(const char *key, T val)
+    inline void CommsMessageBase::addKeyValuePairToArray(const char *key, T val)
     {
         // if (msgIsArray && !nested.isNull())
         if (JsonDoc.is<JsonArray>() && !nested.isNull())
@@ -426,7 +1026,7 @@ namespace LFAST
         }
     }
 
-    inline bool CommsMessage::startNewArray(const char *key)
+    inline bool CommsMessageBase::startNewArray(const char *key)
     {
         // msgIsArray = true;
         arrayKey = key;
@@ -437,7 +1037,7 @@ namespace LFAST
     }
 
     // Returns true if it was able to do this without overflowing?
-    inline bool CommsMessage::startNewArrayObjectItem(const char *key)
+    inline bool CommsMessageBase::startNewArrayObjectItem(const char *key)
     {
         arrayKey = key;
         if (array.isNull())
@@ -447,7 +1047,7 @@ namespace LFAST
         return startNewArrayObjectItem();
     }
 
-    inline bool CommsMessage::startNewArrayObjectItem()
+    inline bool CommsMessageBase::startNewArrayObjectItem()
     {
         bool success = false;
         size_t arrayMemUsageCurr;
@@ -462,11 +1062,12 @@ namespace LFAST
             arrayMemUsageCurr = array.memoryUsage();
             memUsageDiff = arrayMemUsageCurr - arrayMemUsagePrev;
             arrayMemUsagePrev = arrayMemUsageCurr;
-            bool test0 = arrayMemUsageCurr >= JSON_PROGMEM_SIZE;
-            bool test1 = (arrayMemUsageCurr + memUsageDiff + JSON_MAX_ARRAY_ITEM_SIZE) > JSON_PROGMEM_SIZE;
+            bool test0 = arrayMemUsageCurr >= JsonDoc.capacity();
+            bool test1 = (arrayMemUsageCurr + memUsageDiff + JSON_MAX_ARRAY_ITEM_SIZE) > JsonDoc.capacity();
             if (test0 || test1)
             {
                 success = false;
+                truncated = true;
             }
             else
             {
@@ -478,7 +1079,7 @@ namespace LFAST
     }
 
     template <typename T>
-    inline void CommsMessage::addKeyValuePairToArrayObjectItem(const char *key, T val)
+    inline void CommsMessageBase::addKeyValuePairToArrayObjectItem(const char *key, T val)
     {
         if (!nested.isNull())
         {
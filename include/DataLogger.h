@@ -0,0 +1,85 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file DataLogger.h
+/// @brief Fixed-size telemetry logger that never waits on the card
+///
+/// log() only copies a record into the active RAM buffer. When that buffer
+/// fills, it is handed over for writing and logging continues in the other
+/// one. service(), called from the main loop, writes the full buffer a few
+/// DATA_LOG_BLOCK_SIZE blocks per call, so the card only sees whole, aligned
+/// blocks and no single call does much I/O. If the loop can't keep up,
+/// records are dropped (and counted) rather than stalling the caller.
+///
+/// The log starts with a 16 byte header ("LFLOG", version, reserved byte,
+/// uint16 record size, 8 reserved bytes), then the records back to back.
+/// No Arduino dependencies; FileCaptureSink writes to a host file and
+/// SdDataLogSink to a preallocated file on the SD card.
+///
+
+#pragma once
+
+#include "FrameCapture.h"
+
+#include <cinttypes>
+#include <cstddef>
+
+#define DATA_LOG_BLOCK_SIZE 512
+#define DATA_LOG_BUFFER_BLOCKS 16
+#define DATA_LOG_BUFFER_SIZE (DATA_LOG_BLOCK_SIZE * DATA_LOG_BUFFER_BLOCKS)
+#define DATA_LOG_HEADER_SIZE 16
+#define DATA_LOG_FORMAT_VERSION 1
+// Blocks written per service() call unless told otherwise
+#define DATA_LOG_BLOCKS_PER_SERVICE 2
+
+namespace LFAST
+{
+    class DataLogger
+    {
+    public:
+        DataLogger(CaptureSink &_sink, uint16_t _recordSize);
+
+        bool log(const void *record);
+        size_t service(size_t maxBlocks = DATA_LOG_BLOCKS_PER_SERVICE);
+        void close();
+
+        uint16_t recordSize() { return recSize; }
+        uint32_t recordsLogged() { return logged; }
+        uint32_t recordsDropped() { return dropped; }
+        uint32_t blocksWritten() { return blocks; }
+        uint32_t writeErrors() { return errors; }
+        bool writePending() { return fullLen > 0; }
+
+    private:
+        bool append(const uint8_t *data, size_t len);
+        void swapBuffers();
+
+        CaptureSink &sink;
+        uint16_t recSize;
+        uint8_t buffers[2][DATA_LOG_BUFFER_SIZE];
+        // Buffer records are going into, and how much of it is used
+        uint8_t active;
+        size_t activeLen;
+        // Bytes in the other buffer waiting for service(), and how many of those are written
+        size_t fullLen;
+        size_t fullWritten;
+        bool closed;
+
+        uint32_t logged;
+        uint32_t dropped;
+        uint32_t blocks;
+        uint32_t errors;
+    };
+}
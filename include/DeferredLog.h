@@ -0,0 +1,233 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file DeferredLog.h
+/// @brief Binary log that leaves the printf formatting to the host
+///
+/// DEFERRED_LOG(log, "fmt", args...) stores only a 32 bit ID of the format
+/// string (FNV-1a, computed at compile time), a timestamp and the raw argument
+/// bytes in a ring buffer; no formatting happens on the device. drain()
+/// passes whole bytes on to a CaptureSink (SD, serial, host file) a bounded
+/// amount at a time. Each record is:
+///
+///     uint8 0xA5  uint8 arg bytes  uint32 format id  uint32 timestamp (us)  args
+///
+/// Each argument is a one byte type tag followed by its value, little endian:
+/// 'i'/'u' 32 bit int, 'q'/'Q' 64 bit int, 'd' double, 's' uint8 length and
+/// text (cut to DEFERRED_LOG_MAX_STR). scripts/deferred_log/make_format_table.py
+/// pulls the format strings out of the source at build time, and
+/// scripts/deferred_log/decode_log.py turns a drained log back into text.
+/// No Arduino dependencies apart from the optional serial sink.
+///
+
+#pragma once
+
+#include "FrameCapture.h"
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include "HostSerial.h"
+#endif
+
+#define DEFERRED_LOG_SYNC 0xA5
+#define DEFERRED_LOG_HEADER_SIZE 10
+#define DEFERRED_LOG_MAX_STR 32
+
+#if !defined(DEFERRED_LOG_CLOCK)
+#define DEFERRED_LOG_CLOCK() micros()
+#endif
+
+/// Records a message; the format string must be a literal so its ID is a compile time constant
+#define DEFERRED_LOG(log, fmt, ...) \
+    (log).record(std::integral_constant<uint32_t, LFAST::deferredLogId(fmt)>::value, DEFERRED_LOG_CLOCK(), ##__VA_ARGS__)
+
+namespace LFAST
+{
+    /// @brief 32 bit FNV-1a hash of a format string
+    constexpr uint32_t deferredLogId(const char *fmt)
+    {
+        uint32_t hash = 2166136261u;
+        while (*fmt != '\0')
+        {
+            hash ^= (uint8_t)*fmt++;
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+#if defined(ARDUINO)
+    /// @brief Drains a deferred log to a serial port, never more than it can take without blocking
+    class StreamLogSink : public CaptureSink
+    {
+    public:
+        StreamLogSink(Stream &_port) : port(_port) {}
+        bool write(const uint8_t *data, size_t len) override
+        {
+            if (port.availableForWrite() < (int)len)
+                return false;
+            return port.write(data, len) == len;
+        }
+
+    private:
+        Stream &port;
+    };
+#endif
+
+    template <size_t CAPACITY>
+    class DeferredLog
+    {
+        static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "DeferredLog capacity must be a power of two");
+
+    public:
+        DeferredLog() : head(0), tail(0), recorded(0), dropped(0) {}
+
+        /// @brief Appends a record, or drops the whole thing if it doesn't fit
+        template <typename... Args>
+        bool record(uint32_t id, uint32_t timestamp, Args... args)
+        {
+            size_t argBytes = argsSize(args...);
+            if (argBytes > 0xFF || DEFERRED_LOG_HEADER_SIZE + argBytes > space())
+            {
+                dropped++;
+                return false;
+            }
+            put8(DEFERRED_LOG_SYNC);
+            put8((uint8_t)argBytes);
+            put32(id);
+            put32(timestamp);
+            putArgs(args...);
+            recorded++;
+            return true;
+        }
+
+        /// @brief Passes queued bytes to sink, in at most two contiguous writes
+        /// @param maxBytes Most bytes to hand over in this call
+        /// @return Number of bytes written
+        size_t drain(CaptureSink &sink, size_t maxBytes)
+        {
+            size_t sent = 0;
+            while (pending() > 0 && sent < maxBytes)
+            {
+                size_t start = tail & (CAPACITY - 1);
+                size_t chunk = CAPACITY - start;
+                if (chunk > pending())
+                    chunk = pending();
+                if (chunk > maxBytes - sent)
+                    chunk = maxBytes - sent;
+                if (!sink.write(&ring[start], chunk))
+                    break;
+                tail += chunk;
+                sent += chunk;
+            }
+            return sent;
+        }
+
+        size_t pending() { return head - tail; }
+        size_t space() { return CAPACITY - pending(); }
+        uint32_t recordCount() { return recorded; }
+        uint32_t droppedRecords() { return dropped; }
+
+    private:
+        void put8(uint8_t val) { ring[head++ & (CAPACITY - 1)] = val; }
+        void put32(uint32_t val)
+        {
+            for (int ii = 0; ii < 4; ii++)
+                put8((uint8_t)(val >> (8 * ii)));
+        }
+        void put64(uint64_t val)
+        {
+            for (int ii = 0; ii < 8; ii++)
+                put8((uint8_t)(val >> (8 * ii)));
+        }
+
+        static size_t argsSize() { return 0; }
+        template <typename T, typename... Rest>
+        static size_t argsSize(T first, Rest... rest) { return argSize(first) + argsSize(rest...); }
+
+        template <typename T>
+        static typename std::enable_if<std::is_integral<T>::value, size_t>::type argSize(T)
+        {
+            return (sizeof(T) > 4) ? 9 : 5;
+        }
+        template <typename T>
+        static typename std::enable_if<std::is_floating_point<T>::value, size_t>::type argSize(T)
+        {
+            return 9;
+        }
+        static size_t argSize(const char *str) { return 2 + stringLength(str); }
+
+        void putArgs() {}
+        template <typename T, typename... Rest>
+        void putArgs(T first, Rest... rest)
+        {
+            putArg(first);
+            putArgs(rest...);
+        }
+
+        template <typename T>
+        typename std::enable_if<std::is_integral<T>::value>::type putArg(T val)
+        {
+            bool isSigned = std::is_signed<T>::value;
+            if (sizeof(T) > 4)
+            {
+                put8(isSigned ? 'q' : 'Q');
+                put64((uint64_t)val);
+            }
+            else
+            {
+                put8(isSigned ? 'i' : 'u');
+                put32((uint32_t)val);
+            }
+        }
+        template <typename T>
+        typename std::enable_if<std::is_floating_point<T>::value>::type putArg(T val)
+        {
+            double dbl = val;
+            uint64_t bits;
+            std::memcpy(&bits, &dbl, sizeof(bits));
+            put8('d');
+            put64(bits);
+        }
+        void putArg(const char *str)
+        {
+            size_t len = stringLength(str);
+            put8('s');
+            put8((uint8_t)len);
+            for (size_t ii = 0; ii < len; ii++)
+                put8((uint8_t)str[ii]);
+        }
+
+        static size_t stringLength(const char *str)
+        {
+            size_t len = 0;
+            while (str != nullptr && len < DEFERRED_LOG_MAX_STR && str[len] != '\0')
+                len++;
+            return len;
+        }
+
+        uint8_t ring[CAPACITY];
+        // Free running; wrap to an index with & (CAPACITY - 1)
+        size_t head;
+        size_t tail;
+        uint32_t recorded;
+        uint32_t dropped;
+    };
+}
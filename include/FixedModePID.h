@@ -0,0 +1,140 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file FixedModePID.h
+/// @brief PID loop with its compensation mode fixed at compile time
+///
+/// FixedModePID<DIGITAL_CONTROL::PI> etc. takes its terms from the template
+/// parameter instead of working them out from which gains are nonzero.
+/// update() is inline and only contains the terms in MODE, with no
+/// compensationMode tests, and the class has no vtable. Use PID_Controller
+/// when the mode has to change at runtime (e.g. gains tuned from the console).
+///
+/// Compared with PID_ControllerT, update() leaves out two stages. D is the
+/// plain (e - e_prev) / dt, with no configureDerivativeFilter() IIR, and
+/// there is no configureAntiWindup() back-calculation, so while the output is
+/// clamped the integrator is only held back by its own limits.
+///
+
+#pragma once
+
+#include <cinttypes>
+#include "PID_Controller.h"
+
+template <uint8_t MODE, typename T = double>
+class FixedModePID
+{
+    static_assert(MODE == DIGITAL_CONTROL::P || MODE == DIGITAL_CONTROL::PI ||
+                      MODE == DIGITAL_CONTROL::PD || MODE == DIGITAL_CONTROL::PID,
+                  "FixedModePID supports the P, PI, PD and PID modes");
+
+public:
+    static constexpr bool HAS_P = (MODE & DIGITAL_CONTROL::P_BIT) != 0;
+    static constexpr bool HAS_I = (MODE & DIGITAL_CONTROL::I_BIT) != 0;
+    static constexpr bool HAS_D = (MODE & DIGITAL_CONTROL::D_BIT) != 0;
+
+    /// Gains for terms that aren't in MODE are ignored
+    FixedModePID(T _kp = T(0), T _ki = T(0), T _kd = T(0)) : Kp(_kp), Ki(_ki), Kd(_kd) { reset(); }
+
+    void configureGains(T _kp, T _ki, T _kd)
+    {
+        Kp = _kp;
+        Ki = _ki;
+        Kd = _kd;
+    }
+    void configureIntegratorSaturation(T ulim, T llim)
+    {
+        integrator_limits.ulim = ulim;
+        integrator_limits.llim = llim;
+    }
+    void configureOutputSaturation(T ulim, T llim)
+    {
+        output_limits.ulim = ulim;
+        output_limits.llim = llim;
+    }
+    void resetIntegrator() { integratorState = T(0); }
+    void reset()
+    {
+        firstTime = true;
+        e_prev = T(0);
+        outputSaturatedFlag = false;
+        resetIntegrator();
+    }
+    bool integratorIsSaturated()
+    {
+        return HAS_I && ((integratorState == integrator_limits.ulim) || (integratorState == integrator_limits.llim));
+    }
+    bool outputIsSaturated() { return outputSaturatedFlag; }
+
+    inline void update(T e, T dt, T *uC);
+
+private:
+    T Kp;
+    T Ki;
+    T Kd;
+
+    T integratorState;
+    T e_prev;
+    bool firstTime;
+    bool outputSaturatedFlag;
+
+    struct limits
+    {
+        T ulim;
+        T llim;
+    };
+    struct limits integrator_limits
+    {
+        DIGITAL_CONTROL::upperBound<T>(), DIGITAL_CONTROL::lowerBound<T>()
+    };
+    struct limits output_limits
+    {
+        DIGITAL_CONTROL::upperBound<T>(), DIGITAL_CONTROL::lowerBound<T>()
+    };
+};
+
+/// @brief The HAS_ tests are constants, so only the terms in MODE are compiled in
+template <uint8_t MODE, typename T>
+inline void FixedModePID<MODE, T>::update(T e, T dt, T *uC)
+{
+    T output(0);
+
+    if (HAS_P)
+    {
+        output += e * Kp;
+    }
+
+    if (HAS_I)
+    {
+        integratorState += e * Ki * dt;
+        output += DIGITAL_CONTROL::clampToLimits(integratorState, integrator_limits.llim, integrator_limits.ulim);
+    }
+
+    if (HAS_D)
+    {
+        T diff(0);
+        if (!firstTime)
+        {
+            diff = (e - e_prev) / dt;
+        }
+        e_prev = e;
+        firstTime = false;
+        output += diff * Kd;
+    }
+
+    T output_sat = DIGITAL_CONTROL::clampToLimits(output, output_limits.llim, output_limits.ulim);
+    outputSaturatedFlag = (output_sat != output);
+    *uC = output_sat;
+}
@@ -0,0 +1,124 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file FixedPoint.h
+/// @brief Signed 32 bit Q-format fixed point number
+///
+/// FixedPoint<F> holds value * 2^F in an int32_t, so Q16.16 covers about
+/// +/-32768 with a resolution of 1.5e-5. Products and quotients go through 64
+/// bits and every operation saturates at the ends of the range instead of
+/// wrapping, so a wound-up integrator pins rather than flipping sign.
+/// Division by zero saturates toward the dividend's sign.
+///
+
+#pragma once
+
+#include <cinttypes>
+#include <limits>
+
+namespace DIGITAL_CONTROL
+{
+    template <unsigned int FRAC_BITS>
+    class FixedPoint
+    {
+        static_assert(FRAC_BITS > 0 && FRAC_BITS < 31, "FixedPoint needs between 1 and 30 fraction bits");
+
+    public:
+        static constexpr int32_t RAW_MAX = std::numeric_limits<int32_t>::max();
+        static constexpr int32_t RAW_MIN = std::numeric_limits<int32_t>::min();
+        static constexpr double SCALE = (double)(1LL << FRAC_BITS);
+
+        constexpr FixedPoint() : raw(0) {}
+        constexpr FixedPoint(double val) : raw(fromDouble(val)) {}
+
+        static constexpr FixedPoint fromRaw(int32_t r)
+        {
+            FixedPoint fp;
+            fp.raw = r;
+            return fp;
+        }
+        constexpr int32_t rawValue() const { return raw; }
+        constexpr double toDouble() const { return raw / SCALE; }
+        explicit constexpr operator double() const { return toDouble(); }
+        explicit constexpr operator float() const { return (float)toDouble(); }
+
+        constexpr FixedPoint operator+(FixedPoint rhs) const { return fromRaw(clamp((int64_t)raw + rhs.raw)); }
+        constexpr FixedPoint operator-(FixedPoint rhs) const { return fromRaw(clamp((int64_t)raw - rhs.raw)); }
+        constexpr FixedPoint operator-() const { return fromRaw(clamp(-(int64_t)raw)); }
+        constexpr FixedPoint operator*(FixedPoint rhs) const
+        {
+            // Round to nearest rather than toward -infinity
+            return fromRaw(clamp(((int64_t)raw * rhs.raw + (1LL << (FRAC_BITS - 1))) >> FRAC_BITS));
+        }
+        constexpr FixedPoint operator/(FixedPoint rhs) const
+        {
+            if (rhs.raw == 0)
+                return fromRaw(raw >= 0 ? RAW_MAX : RAW_MIN);
+            return fromRaw(clamp(((int64_t)raw * (1LL << FRAC_BITS)) / rhs.raw));
+        }
+
+        FixedPoint &operator+=(FixedPoint rhs) { return *this = *this + rhs; }
+        FixedPoint &operator-=(FixedPoint rhs) { return *this = *this - rhs; }
+        FixedPoint &operator*=(FixedPoint rhs) { return *this = *this * rhs; }
+        FixedPoint &operator/=(FixedPoint rhs) { return *this = *this / rhs; }
+
+        constexpr bool operator==(FixedPoint rhs) const { return raw == rhs.raw; }
+        constexpr bool operator!=(FixedPoint rhs) const { return raw != rhs.raw; }
+        constexpr bool operator<(FixedPoint rhs) const { return raw < rhs.raw; }
+        constexpr bool operator>(FixedPoint rhs) const { return raw > rhs.raw; }
+        constexpr bool operator<=(FixedPoint rhs) const { return raw <= rhs.raw; }
+        constexpr bool operator>=(FixedPoint rhs) const { return raw >= rhs.raw; }
+
+    private:
+        static constexpr int32_t clamp(int64_t val)
+        {
+            return val > RAW_MAX ? RAW_MAX : (val < RAW_MIN ? RAW_MIN : (int32_t)val);
+        }
+        static constexpr int32_t fromDouble(double val)
+        {
+            double scaled = val * SCALE;
+            if (scaled >= (double)RAW_MAX)
+                return RAW_MAX;
+            if (scaled <= (double)RAW_MIN)
+                return RAW_MIN;
+            return (int32_t)(scaled + (scaled >= 0 ? 0.5 : -0.5));
+        }
+
+        int32_t raw;
+    };
+
+    typedef FixedPoint<16> Q16_16;
+}
+
+namespace std
+{
+    template <unsigned int FRAC_BITS>
+    class numeric_limits<DIGITAL_CONTROL::FixedPoint<FRAC_BITS>>
+    {
+        typedef DIGITAL_CONTROL::FixedPoint<FRAC_BITS> FP;
+
+    public:
+        static constexpr bool is_specialized = true;
+        static constexpr bool is_signed = true;
+        static constexpr bool is_integer = false;
+        static constexpr bool is_exact = true;
+        static constexpr bool has_infinity = false;
+        static constexpr FP min() { return FP::fromRaw(1); }
+        static constexpr FP max() { return FP::fromRaw(FP::RAW_MAX); }
+        static constexpr FP lowest() { return FP::fromRaw(FP::RAW_MIN); }
+        static constexpr FP epsilon() { return FP::fromRaw(1); }
+        static constexpr FP infinity() { return max(); }
+    };
+}
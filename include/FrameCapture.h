@@ -0,0 +1,199 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file FrameCapture.h
+/// @brief Compact binary log of received frames, for replaying real traffic
+///
+/// A capture is an 8 byte file header ("LFCAP", version, 2 reserved bytes)
+/// followed by one record per frame:
+///
+///     uint32 timestamp (us)  uint16 connection id  uint16 length  payload
+///
+/// The connection id is ClientConnection::id (0xFFFF if the frame couldn't be
+/// attributed to a connection). All fields are little endian. The writer packs records into
+/// CAPTURE_BLOCK_SIZE blocks so an SD card only ever sees whole-block writes.
+/// No Arduino dependencies, so it builds on host (see SdCaptureSink.h for the
+/// device sink). test/capture_replay_bench.cc replays a capture through the
+/// framers and dispatcher on the host, and
+/// scripts/socket_test_scripts/capture_replay.py plays one back at a device.
+///
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#define CAPTURE_BLOCK_SIZE 512
+#define CAPTURE_FILE_HEADER_SIZE 8
+#define CAPTURE_RECORD_HEADER_SIZE 8
+#define CAPTURE_FORMAT_VERSION 1
+
+namespace LFAST
+{
+    /// @brief Where capture blocks end up
+    class CaptureSink
+    {
+    public:
+        virtual ~CaptureSink() {}
+        virtual bool write(const uint8_t *data, size_t len) = 0;
+        virtual void flush() {}
+    };
+
+    /// @brief Capture sink for a stdio file (host builds)
+    class FileCaptureSink : public CaptureSink
+    {
+    public:
+        FileCaptureSink(FILE *_file) : file(_file) {}
+        bool write(const uint8_t *data, size_t len) override
+        {
+            return file != nullptr && fwrite(data, 1, len, file) == len;
+        }
+        void flush() override
+        {
+            if (file != nullptr)
+                fflush(file);
+        }
+
+    private:
+        FILE *file;
+    };
+
+    struct CaptureRecord
+    {
+        uint32_t timestampUs;
+        uint16_t connectionId;
+        uint16_t length;
+        const uint8_t *payload;
+    };
+
+    class FrameCaptureWriter
+    {
+    public:
+        FrameCaptureWriter(CaptureSink &_sink)
+            : sink(_sink), blockLen(0), recordCount(0), writeErrors(0)
+        {
+            static const uint8_t fileHeader[CAPTURE_FILE_HEADER_SIZE] = {'L', 'F', 'C', 'A', 'P', CAPTURE_FORMAT_VERSION, 0, 0};
+            append(fileHeader, sizeof(fileHeader));
+        }
+        ~FrameCaptureWriter() { flush(); }
+
+        /// @brief Appends one frame; payloads longer than 65535 bytes are cut short
+        void record(uint32_t timestampUs, uint16_t connectionId, const uint8_t *payload, size_t len)
+        {
+            uint16_t length = len > 0xFFFF ? 0xFFFF : (uint16_t)len;
+            uint8_t header[CAPTURE_RECORD_HEADER_SIZE];
+            putLE(header, timestampUs, 4);
+            putLE(header + 4, connectionId, 2);
+            putLE(header + 6, length, 2);
+            append(header, sizeof(header));
+            append(payload, length);
+            recordCount++;
+        }
+
+        /// @brief Writes out the partly filled block
+        void flush()
+        {
+            if (blockLen > 0)
+                writeBlock();
+            sink.flush();
+        }
+
+        unsigned int records() { return recordCount; }
+        unsigned int errors() { return writeErrors; }
+
+    private:
+        static void putLE(uint8_t *dest, uint32_t val, size_t nBytes)
+        {
+            for (size_t ii = 0; ii < nBytes; ii++)
+                dest[ii] = (uint8_t)(val >> (8 * ii));
+        }
+
+        void append(const uint8_t *data, size_t len)
+        {
+            while (len > 0)
+            {
+                size_t chunk = CAPTURE_BLOCK_SIZE - blockLen;
+                if (chunk > len)
+                    chunk = len;
+                std::memcpy(block + blockLen, data, chunk);
+                blockLen += chunk;
+                data += chunk;
+                len -= chunk;
+                if (blockLen == CAPTURE_BLOCK_SIZE)
+                    writeBlock();
+            }
+        }
+
+        void writeBlock()
+        {
+            if (!sink.write(block, blockLen))
+                writeErrors++;
+            blockLen = 0;
+        }
+
+        CaptureSink &sink;
+        uint8_t block[CAPTURE_BLOCK_SIZE];
+        size_t blockLen;
+        unsigned int recordCount;
+        unsigned int writeErrors;
+    };
+
+    /// @brief Walks the records of a capture held in memory
+    class FrameCaptureReader
+    {
+    public:
+        FrameCaptureReader(const uint8_t *_data, size_t _len)
+            : data(_data), len(_len), pos(CAPTURE_FILE_HEADER_SIZE) {}
+
+        /// @brief True if the buffer starts with a capture header this reader understands
+        bool valid()
+        {
+            return len >= CAPTURE_FILE_HEADER_SIZE && std::memcmp(data, "LFCAP", 5) == 0 &&
+                   data[5] == CAPTURE_FORMAT_VERSION;
+        }
+
+        /// @brief Reads the next record; rec.payload points into the capture buffer
+        /// @return false at the end of the capture (or at a truncated record)
+        bool next(CaptureRecord &rec)
+        {
+            if (!valid() || pos + CAPTURE_RECORD_HEADER_SIZE > len)
+                return false;
+            const uint8_t *hdr = data + pos;
+            rec.timestampUs = getLE(hdr, 4);
+            rec.connectionId = (uint16_t)getLE(hdr + 4, 2);
+            rec.length = (uint16_t)getLE(hdr + 6, 2);
+            if (pos + CAPTURE_RECORD_HEADER_SIZE + rec.length > len)
+                return false;
+            rec.payload = hdr + CAPTURE_RECORD_HEADER_SIZE;
+            pos += CAPTURE_RECORD_HEADER_SIZE + rec.length;
+            return true;
+        }
+
+    private:
+        static uint32_t getLE(const uint8_t *src, size_t nBytes)
+        {
+            uint32_t val = 0;
+            for (size_t ii = 0; ii < nBytes; ii++)
+                val |= (uint32_t)src[ii] << (8 * ii);
+            return val;
+        }
+
+        const uint8_t *data;
+        size_t len;
+        size_t pos;
+    };
+}
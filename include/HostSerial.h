@@ -0,0 +1,98 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file HostSerial.h
+/// @brief Stand-in for the Teensy serial port when building off-target
+///
+/// Implements the part of the Arduino serial API that TerminalInterface
+/// uses, over plain file descriptors (stdout, a pty, a pipe). It also counts
+/// bytes and write() syscalls, so terminal rendering can be measured on Linux.
+/// millis(), micros() and delay() are provided here too for non-Arduino builds.
+///
+
+#pragma once
+
+#if !defined(ARDUINO)
+
+#include <cinttypes>
+#include <cstddef>
+#include <chrono>
+#include <thread>
+
+#include <poll.h>
+#include <unistd.h>
+
+inline uint32_t millis()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline uint32_t micros()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline void delay(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+class HostSerial
+{
+public:
+    HostSerial(int _inFd = STDIN_FILENO, int _outFd = STDOUT_FILENO)
+        : txRoom(4096), bytesWritten(0), writeCalls(0), inFd(_inFd), outFd(_outFd) {}
+
+    void begin(uint32_t) {}
+
+    int available()
+    {
+        if (inFd < 0)
+            return 0;
+        pollfd pfd = {inFd, POLLIN, 0};
+        return (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN)) ? 1 : 0;
+    }
+
+    int read()
+    {
+        unsigned char c;
+        return (inFd >= 0 && ::read(inFd, &c, 1) == 1) ? c : -1;
+    }
+
+    /// @brief Pretends to have a TX buffer of txRoom bytes, like the UART/USB drivers
+    int availableForWrite() { return (int)txRoom; }
+
+    size_t write(const uint8_t *data, size_t len)
+    {
+        writeCalls++;
+        ssize_t ret = ::write(outFd, data, len);
+        if (ret <= 0)
+            return 0;
+        bytesWritten += ret;
+        return (size_t)ret;
+    }
+
+    size_t txRoom;
+    uint64_t bytesWritten;
+    uint64_t writeCalls;
+
+private:
+    int inFd;
+    int outFd;
+};
+
+#endif
@@ -0,0 +1,63 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file JsonArena.h
+/// @brief Bump allocator for message objects and their JSON documents
+///
+/// Everything CommsService allocates while handling a loop tick (received
+/// messages and the JSON pools behind them) comes out of one statically sized
+/// arena. Frees are just bookkeeping; once per tick reset() rewinds the arena
+/// to the end of the newest block still alive, so a message that outlives its
+/// tick holds on to its own space but not to what comes after it. If the
+/// arena runs out, allocations fall back to malloc and are counted so
+/// JSON_ARENA_SIZE can be sized from real traffic.
+///
+/// To change the arena size, define JSON_ARENA_SIZE in the build flags.
+///
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#ifndef JSON_ARENA_SIZE
+#define JSON_ARENA_SIZE 16384
+#endif
+
+namespace LFAST
+{
+    class JsonArena
+    {
+    public:
+        static void *allocate(size_t size);
+        static void deallocate(void *ptr);
+        static void *reallocate(void *ptr, size_t newSize);
+        static bool reset();
+
+        static size_t bytesUsed() { return head; }
+        static size_t highWaterMark() { return highWater; }
+        static unsigned int liveAllocations() { return liveCount; }
+        static unsigned int fallbackAllocations() { return fallbackCount; }
+
+    private:
+        static bool owns(void *ptr);
+
+        static uint8_t pool[JSON_ARENA_SIZE];
+        static size_t head;
+        static size_t highWater;
+        static unsigned int liveCount;
+        static unsigned int fallbackCount;
+    };
+}
@@ -0,0 +1,177 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file MultiAxisPID.h
+/// @brief N identical PID loops updated together
+///
+/// Gains, states and limits for all axes are kept in contiguous arrays and
+/// update() advances every axis in one branch-free loop the compiler can
+/// vectorize. Unused terms just have a zero gain rather than being skipped,
+/// and unset limits are +/-infinity so the clamps are always applied. No heap
+/// allocation.
+///
+/// Each axis is PID_Controller's proportional, clamped integrator and output
+/// clamp, minus two stages: the derivative is always the raw backward
+/// difference (no configureDerivativeFilter() low-pass), and there is no
+/// configureAntiWindup() Kb back-calculation, so the integrator is held only
+/// by its own saturation limits while the output is clamped.
+///
+
+#pragma once
+
+#include <cinttypes>
+#include "PID_Controller.h"
+#include "math_util.h"
+
+template <unsigned int N>
+class MultiAxisPID
+{
+public:
+    MultiAxisPID();
+
+    void configureGains(unsigned int axis, double _kp, double _ki, double _kd);
+    void configureIntegratorSaturation(unsigned int axis, double ulim, double llim);
+    void configureOutputSaturation(unsigned int axis, double ulim, double llim);
+    void resetIntegrator(unsigned int axis);
+    void reset();
+    void update(const double *e, double dt, double *uC);
+    bool integratorIsSaturated(unsigned int axis);
+    bool outputIsSaturated(unsigned int axis);
+
+    static constexpr unsigned int numAxes() { return N; }
+
+private:
+    alignas(16) double Kp[N];
+    alignas(16) double Ki[N];
+    alignas(16) double Kd[N];
+
+    alignas(16) double integratorState[N];
+    alignas(16) double e_prev[N];
+    // 0 until an axis has a previous error to difference against, then 1
+    alignas(16) double diffValid[N];
+
+    alignas(16) double integrator_ulim[N];
+    alignas(16) double integrator_llim[N];
+    alignas(16) double output_ulim[N];
+    alignas(16) double output_llim[N];
+
+    uint8_t outputSaturatedFlag[N];
+};
+
+template <unsigned int N>
+MultiAxisPID<N>::MultiAxisPID()
+{
+    for (unsigned int ii = 0; ii < N; ii++)
+    {
+        Kp[ii] = 0.0;
+        Ki[ii] = 0.0;
+        Kd[ii] = 0.0;
+        integrator_ulim[ii] = DIGITAL_CONTROL::pos_inf;
+        integrator_llim[ii] = DIGITAL_CONTROL::neg_inf;
+        output_ulim[ii] = DIGITAL_CONTROL::pos_inf;
+        output_llim[ii] = DIGITAL_CONTROL::neg_inf;
+    }
+    reset();
+}
+
+template <unsigned int N>
+void MultiAxisPID<N>::configureGains(unsigned int axis, double _kp, double _ki, double _kd)
+{
+    if (axis >= N)
+        return;
+    Kp[axis] = _kp;
+    Ki[axis] = _ki;
+    Kd[axis] = _kd;
+}
+
+template <unsigned int N>
+void MultiAxisPID<N>::configureIntegratorSaturation(unsigned int axis, double ulim, double llim)
+{
+    if (axis >= N)
+        return;
+    integrator_ulim[axis] = ulim;
+    integrator_llim[axis] = llim;
+}
+
+template <unsigned int N>
+void MultiAxisPID<N>::configureOutputSaturation(unsigned int axis, double ulim, double llim)
+{
+    if (axis >= N)
+        return;
+    output_ulim[axis] = ulim;
+    output_llim[axis] = llim;
+}
+
+template <unsigned int N>
+void MultiAxisPID<N>::resetIntegrator(unsigned int axis)
+{
+    if (axis < N)
+        integratorState[axis] = 0.0;
+}
+
+template <unsigned int N>
+void MultiAxisPID<N>::reset()
+{
+    for (unsigned int ii = 0; ii < N; ii++)
+    {
+        integratorState[ii] = 0.0;
+        e_prev[ii] = 0.0;
+        diffValid[ii] = 0.0;
+        outputSaturatedFlag[ii] = 0;
+    }
+}
+
+template <unsigned int N>
+bool MultiAxisPID<N>::integratorIsSaturated(unsigned int axis)
+{
+    if (axis >= N)
+        return false;
+    return (integratorState[axis] == integrator_ulim[axis]) || (integratorState[axis] == integrator_llim[axis]);
+}
+
+template <unsigned int N>
+bool MultiAxisPID<N>::outputIsSaturated(unsigned int axis)
+{
+    return (axis < N) && outputSaturatedFlag[axis];
+}
+
+/// @brief Advances every axis by one step
+/// @param e Error for each axis (N values)
+/// @param dt Time step, shared by all axes. A step that isn't positive leaves
+/// the integrators alone and drops the derivative term for this update, so
+/// only the proportional term acts.
+/// @param uC Control output for each axis (N values)
+template <unsigned int N>
+void MultiAxisPID<N>::update(const double *e, double dt, double *uC)
+{
+    // Also catches NaN, and keeps 0*inf out of axes with no derivative gain
+    if (!(dt > 0.0))
+        dt = 0.0;
+    const double inv_dt = (dt > 0.0) ? 1.0 / dt : 0.0;
+    for (unsigned int ii = 0; ii < N; ii++)
+    {
+        const double e_ii = e[ii];
+        integratorState[ii] += e_ii * Ki[ii] * dt;
+        double int_term = saturate(integratorState[ii], integrator_llim[ii], integrator_ulim[ii]);
+        double diff = (e_ii - e_prev[ii]) * inv_dt * diffValid[ii];
+        e_prev[ii] = e_ii;
+        diffValid[ii] = 1.0;
+
+        double output = e_ii * Kp[ii] + int_term + diff * Kd[ii];
+        double output_sat = saturate(output, output_llim[ii], output_ulim[ii]);
+        outputSaturatedFlag[ii] = (output_sat != output);
+        uC[ii] = output_sat;
+    }
+}
@@ -20,6 +20,8 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 
 #include <cinttypes>
 #include <limits>
+#include "FixedPoint.h"
+#include "df2_filter.h"
 
 namespace DIGITAL_CONTROL
 {
@@ -40,50 +42,97 @@ namespace DIGITAL_CONTROL
         ID = I_BIT | D_BIT,
         PID = P_BIT | I_BIT | D_BIT
     };
+
+    /// @brief +infinity, or the largest value for types that don't have one
+    template <typename T>
+    constexpr T upperBound()
+    {
+        return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+    }
+
+    /// @brief -infinity, or the most negative value for types that don't have one
+    template <typename T>
+    constexpr T lowerBound()
+    {
+        return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+    }
+
+    /// @brief saturate() from math_util.h only takes arithmetic types, which FixedPoint isn't
+    template <typename T>
+    inline T clampToLimits(T val, T lower, T upper)
+    {
+        T val1 = val > lower ? val : lower;
+        return val1 < upper ? val1 : upper;
+    }
 };
 
-class PID_Controller
+// Order of the optional derivative filter, matching the 2nd order tables in df2_filter.h
+#define PID_DERIVATIVE_FILTER_ORDER 2
+
+/// @brief PID loop on a chosen scalar type
+///
+/// Instantiated in PID_Controller.cc for double, float and Q16_16 fixed point.
+/// PID_Controller is the double version. Limits that haven't been configured
+/// sit at +/-infinity, or at the ends of the range for types without one.
+///
+/// Each update() does, in order: P term, integrator (clamped to its limits),
+/// D term (raw difference or the derivative filter), output saturation, then
+/// back-calculation of the saturation error into the integrator if an
+/// anti-windup gain is set.
+template <typename T>
+class PID_ControllerT
 {
 public:
-    PID_Controller(double _kp = 0.0, double _ki = 0.0, double _kd = 0.0);
-    virtual ~PID_Controller() {}
-    void configureGains(double _kp, double _ki, double _kd);
-    void configureIntegratorSaturation(double ulim, double llim);
-    void configureOutputSaturation(double ulim, double llim);
+    PID_ControllerT(T _kp = T(0), T _ki = T(0), T _kd = T(0));
+    virtual ~PID_ControllerT() {}
+    void configureGains(T _kp, T _ki, T _kd);
+    void configureIntegratorSaturation(T ulim, T llim);
+    void configureOutputSaturation(T ulim, T llim);
+    void configureDerivativeFilter(const double *b, const double *a);
+    void disableDerivativeFilter();
+    void configureAntiWindup(T _kb);
     void resetIntegrator();
     void reset();
-    void update(double e, double dt, double *uC);
+    void update(T e, T dt, T *uC);
     bool integratorIsSaturated();
     bool outputIsSaturated();
 
 private:
 
-    double Kp;
-    double Ki;
-    double Kd;
+    T Kp;
+    T Ki;
+    T Kd;
+    // Back-calculation gain, 0 for off
+    T Kb;
 
     bool limit_integrator;
     bool limit_output;
-    double integratorState;
+    bool filter_derivative;
+    StaticDF2_IIR<T, PID_DERIVATIVE_FILTER_ORDER> diffFilter;
+    T integratorState;
     bool outputSaturatedFlag;
-    double e_prev;
+    T e_prev;
     bool firstTime;
 
     struct limits
     {
-        double ulim;
-        double llim;
+        T ulim;
+        T llim;
     };
     struct limits integrator_limits
     {
-        DIGITAL_CONTROL::pos_inf, DIGITAL_CONTROL::neg_inf
+        DIGITAL_CONTROL::upperBound<T>(), DIGITAL_CONTROL::lowerBound<T>()
     };
     struct limits output_limits
     {
-        DIGITAL_CONTROL::pos_inf, DIGITAL_CONTROL::neg_inf
+        DIGITAL_CONTROL::upperBound<T>(), DIGITAL_CONTROL::lowerBound<T>()
     };
 
     uint8_t compensationMode;
     void configureCompMode();
     // bool anti_windup;
-};
\ No newline at end of file
+};
+
+typedef PID_ControllerT<double> PID_Controller;
+typedef PID_ControllerT<float> PID_ControllerF;
+typedef PID_ControllerT<DIGITAL_CONTROL::Q16_16> PID_ControllerQ16;
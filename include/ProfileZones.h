@@ -0,0 +1,109 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file ProfileZones.h
+/// @brief Named timing zones for finding where loop time goes
+///
+///     void PMC::servicePositionLoop()
+///     {
+///         PROFILE_ZONE("PositionLoop");
+///         ...
+///     }
+///
+/// Each zone keeps a call count and total/min/max microseconds. The zone is
+/// looked up once (the first time through) and each pass costs two clock reads.
+/// The terminal's "zones" command prints them and "reset" clears them.
+///
+
+#pragma once
+
+#include "macro.h"
+
+#include <cinttypes>
+#include <cstddef>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include "HostSerial.h"
+#endif
+#define PROFILE_CLOCK() micros()
+
+#define MAX_PROFILE_ZONES 24
+
+/// Times the rest of the enclosing scope under the given name (a string literal)
+#define PROFILE_ZONE(name)                                                                             \
+    static LFAST::ProfileZone *const CONCAT(profileZone_, __LINE__) = LFAST::ProfileZones::zone(name); \
+    LFAST::ProfileScope CONCAT(profileScope_, __LINE__)(CONCAT(profileZone_, __LINE__))
+
+namespace LFAST
+{
+    struct ProfileZone
+    {
+        const char *name;
+        uint32_t count;
+        uint64_t totalUs;
+        uint32_t minUs;
+        uint32_t maxUs;
+
+        void add(uint32_t us)
+        {
+            count++;
+            totalUs += us;
+            if (us < minUs)
+                minUs = us;
+            if (us > maxUs)
+                maxUs = us;
+        }
+        void reset()
+        {
+            count = 0;
+            totalUs = 0;
+            minUs = UINT32_MAX;
+            maxUs = 0;
+        }
+        uint32_t meanUs() { return count > 0 ? (uint32_t)(totalUs / count) : 0; }
+    };
+
+    /// @brief Fixed table of every zone in the program
+    class ProfileZones
+    {
+    public:
+        static ProfileZone *zone(const char *name);
+        static size_t count() { return numZones; }
+        static ProfileZone &at(size_t idx) { return zones[idx]; }
+        static void resetAll();
+
+    private:
+        static ProfileZone zones[MAX_PROFILE_ZONES];
+        static size_t numZones;
+    };
+
+    /// @brief Adds the time from construction to destruction to a zone
+    class ProfileScope
+    {
+    public:
+        ProfileScope(ProfileZone *_zone) : zone(_zone), startUs(PROFILE_CLOCK()) {}
+        ~ProfileScope()
+        {
+            if (zone != nullptr)
+                zone->add(PROFILE_CLOCK() - startUs);
+        }
+
+    private:
+        ProfileZone *zone;
+        uint32_t startUs;
+    };
+}
@@ -0,0 +1,62 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file SdCaptureSink.h
+/// @brief Frame capture sink that writes to a file on the Teensy's built-in SD card
+///
+
+#pragma once
+
+#include <SD.h>
+#include "FrameCapture.h"
+
+namespace LFAST
+{
+    class SdCaptureSink : public CaptureSink
+    {
+    public:
+        SdCaptureSink() {}
+        virtual ~SdCaptureSink() { close(); }
+
+        /// @brief Starts the SD card (if needed) and creates/truncates the capture file
+        bool open(const char *fileName)
+        {
+            if (!SD.begin(BUILTIN_SDCARD))
+                return false;
+            if (SD.exists(fileName))
+                SD.remove(fileName);
+            file = SD.open(fileName, FILE_WRITE);
+            return (bool)file;
+        }
+        void close()
+        {
+            if (file)
+                file.close();
+        }
+
+        bool write(const uint8_t *data, size_t len) override
+        {
+            return file && file.write(data, len) == len;
+        }
+        void flush() override
+        {
+            if (file)
+                file.flush();
+        }
+
+    private:
+        File file;
+    };
+}
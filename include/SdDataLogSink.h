@@ -0,0 +1,70 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file SdDataLogSink.h
+/// @brief DataLogger sink for a preallocated file on the Teensy's built-in SD card
+///
+/// Goes through SdFat (SD.sdfs) directly so the file can be preallocated as
+/// one contiguous run of clusters; block writes then never stop to search
+/// the FAT. Space that wasn't used is given back on close().
+///
+
+#pragma once
+
+#include <SD.h>
+#include "FrameCapture.h"
+
+namespace LFAST
+{
+    class SdDataLogSink : public CaptureSink
+    {
+    public:
+        SdDataLogSink() {}
+        virtual ~SdDataLogSink() { close(); }
+
+        /// @brief Starts the SD card (if needed), then creates/truncates and preallocates the log file
+        /// @param preallocBytes Expected size of the log; a longer log still works, just not contiguously
+        bool open(const char *fileName, uint64_t preallocBytes)
+        {
+            if (!SD.begin(BUILTIN_SDCARD))
+                return false;
+            file = SD.sdfs.open(fileName, O_RDWR | O_CREAT | O_TRUNC);
+            if (!file)
+                return false;
+            return file.preAllocate(preallocBytes);
+        }
+        void close()
+        {
+            if (file)
+            {
+                file.truncate();
+                file.close();
+            }
+        }
+
+        bool write(const uint8_t *data, size_t len) override
+        {
+            return file && file.write(data, len) == len;
+        }
+        void flush() override
+        {
+            if (file)
+                file.flush();
+        }
+
+    private:
+        FsFile file;
+    };
+}
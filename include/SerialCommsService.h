@@ -0,0 +1,89 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file SerialCommsService.h
+///
+/// Serial (UART/RS-485/USB) transport for the LFAST Comms library. Any Stream
+/// can be added as a link; each link becomes a CommsService connection and is
+/// served by the same handler registry as the Ethernet transports.
+///
+/// Messages are COBS framed (see cobs_framing.h): every frame is terminated by
+/// a 0x00 byte, so the receiver can pull whatever the UART has buffered in one
+/// bulk read and resynchronize after noise. Frames may hold JSON or MessagePack.
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+
+#include "CommService.h"
+#include "cobs_framing.h"
+
+#ifndef MAX_SERIAL_LINKS
+#define MAX_SERIAL_LINKS 2
+#endif
+#define SERIAL_RX_CHUNK_SIZE 64
+
+namespace LFAST
+{
+    /// @brief Adapts a Stream into a Client so it can back a ClientConnection
+    class StreamClient : public Client
+    {
+    public:
+        StreamClient(Stream &_stream) : stream(_stream) {}
+        virtual ~StreamClient() {}
+
+        int connect(IPAddress, uint16_t) override { return 0; }
+        int connect(const char *, uint16_t) override { return 0; }
+        size_t write(uint8_t b) override { return stream.write(b); }
+        size_t write(const uint8_t *buf, size_t size) override { return stream.write(buf, size); }
+        int available() override { return stream.available(); }
+        int read() override { return stream.read(); }
+        int read(uint8_t *buf, size_t size) override { return stream.readBytes((char *)buf, size); }
+        int peek() override { return stream.peek(); }
+        void flush() override { stream.flush(); }
+        void stop() override {}
+        uint8_t connected() override { return 1; }
+        operator bool() override { return true; }
+
+        Stream &stream;
+    };
+
+    class SerialCommsService : public CommsService
+    {
+    protected:
+        struct SerialLink
+        {
+            SerialLink(Stream &s) : client(s), decodeErrorsSeen(0) {}
+            StreamClient client;
+            // Leave room for the null terminator the JSON parser needs
+            CobsFrameDecoder<LARGE_MSG_BUFF_SIZE - 1> decoder;
+            unsigned int decodeErrorsSeen;
+        };
+        std::list<SerialLink> serialLinks;
+        ClientConnection *getLinkConnection(SerialLink &);
+        void sendFrame(CommsMessageBase &, ClientConnection &);
+
+    public:
+        SerialCommsService(){};
+        virtual ~SerialCommsService(){};
+        bool initializeSerialIface(HardwareSerial &, uint32_t, int txEnablePin = -1);
+        bool addSerialLink(Stream &);
+
+        bool Status() override { return this->commsServiceStatus; }
+        bool checkForNewClientData() override;
+        void sendMessage(CommsMessageBase &, uint8_t) override;
+    };
+}
@@ -45,7 +45,7 @@ namespace LFAST
     {
     protected:
     static bool hardwareConfigurationDone;
-        void getTeensyMacAddr(uint8_t *mac);
+        static void getTeensyMacAddr(uint8_t *mac);
         static byte mac[6];
         IPAddress ip;
         EthernetServer *tcpServer;
@@ -55,6 +55,7 @@ namespace LFAST
         TcpCommsService(byte *);
         virtual ~TcpCommsService(){};
         bool initializeEnetIface(uint16_t);
+        static bool configureEnetHardware(IPAddress &);
 
         bool Status() override { return this->commsServiceStatus; }
         bool checkForNewClients() override;
@@ -0,0 +1,88 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file TerminalFormat.h
+/// @brief Fixed-buffer formatting for TerminalInterface's log lines
+///
+/// Nothing here touches the heap (apart from DEBUG_CODE_ID_STR, kept as a
+/// std::string for existing callers), and there are no Arduino dependencies,
+/// so the same code is benchmarked and tested on host.
+///
+
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace LFAST
+{
+    /// @brief Renders one debug log line into out
+    ///
+    /// Same text the old stringstream version produced: the leading white
+    /// color code is left-justified to 12 columns (that's where its setw()
+    /// landed), then "count[millis]: ", the level color, and the message.
+    /// Line breaks become spaces so the line can't leave its row.
+    ///
+    /// @return Length of the line in out (cut short to fit if needed)
+    inline size_t formatDebugLine(char *out, size_t outLen, unsigned int count, unsigned long ms,
+                                  const char *color, const char *msg)
+    {
+        if (outLen == 0)
+            return 0;
+        int ret = snprintf(out, outLen, "%-12s%u[%lu]: %s%s", "\033[37m", count, ms, color, msg);
+        if (ret < 0)
+        {
+            out[0] = '\0';
+            return 0;
+        }
+        size_t len = ((size_t)ret < outLen) ? (size_t)ret : outLen - 1;
+        for (size_t ii = 0; ii < len; ii++)
+        {
+            if (out[ii] == '\r' || out[ii] == '\n')
+                out[ii] = ' ';
+        }
+        return len;
+    }
+
+    /// @brief "file.cc[line]" for a source location, without the directories
+    struct DebugCodeId
+    {
+        DebugCodeId(const char *file, int line)
+        {
+            const char *name = std::strrchr(file, '/');
+            name = (name != nullptr) ? name + 1 : file;
+            snprintf(str, sizeof(str), "%s[%d]", name, line);
+        }
+        const char *c_str() const { return str; }
+
+        char str[48];
+    };
+}
+
+/// @brief "file[line]" as a std::string, as DEBUG_CODE_ID_STR has always given it
+inline std::string debugCodeIdStr(const char *file, int line)
+{
+    return std::string(LFAST::DebugCodeId(file, line).c_str());
+}
+inline std::string debugCodeIdStr(const std::string &file, int line)
+{
+    return debugCodeIdStr(file.c_str(), line);
+}
+
+#define DEBUG_CODE_ID_STR debugCodeIdStr(__FILE__, __LINE__)
+// Same text without the heap; keep the object alive while its c_str() is in use
+#define DEBUG_CODE_ID LFAST::DebugCodeId(__FILE__, __LINE__)
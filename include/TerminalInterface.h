@@ -21,15 +21,20 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 /// - To set the baud rate, edit the TEST_SERIAL_BAUD in platformio.ini
 
 #pragma once
+#if defined(ARDUINO)
 #include <Arduino.h>
+#endif
 #include <cinttypes>
-#include <deque>
 #include <string>
 #include <vector>
 #include <map>
 #include <cstdio>
 
 #include <teensy41_device.h>
+#include "TerminalScreenBuffer.h"
+#include "TerminalOutputQueue.h"
+#include "TerminalFormat.h"
+#include "ProfileZones.h"
 
 // #if defined(TERMINAL_ENABLED)
 #define CLI_BUFF_LENGTH 90
@@ -46,6 +51,16 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #define TERMINAL_WIDTH 95
 #define PRINT_SERVICE_COUNTER 0
 #define MAX_MSG_CHARS 100
+// Room for the count/timestamp prefix and color codes around a message
+#define DEBUG_LINE_CHARS (MAX_MSG_CHARS + 48)
+
+// All terminal output is queued here and sent a little at a time from serviceCLI()
+#define TERMINAL_TX_QUEUE_SIZE 8192
+#define TERMINAL_DRAIN_BYTES_PER_CALL 256
+// How often changed persistent field values are repainted
+#define TERMINAL_FRAME_RATE_HZ 10
+// Longest printf format a double persistent field keeps (including the terminator)
+#define PERSISTENT_FIELD_FMT_SIZE 16
 
 namespace LFAST
 {
@@ -69,8 +84,44 @@ namespace LFAST
 
     const unsigned int MAX_DEBUG_ROWS = 15;
     const unsigned int MAX_CLOCKBUFF_LEN = 64;
+
+    /// @brief Returned by addPersistentField(); updates through it skip the device lookup
+    ///
+    /// Holds the field's terminal row. The value column is shared by every field
+    /// (it lines up after the longest label), so it's read from the interface.
+    struct PersistentFieldHandle
+    {
+        uint16_t row = 0xFFFF;
+        bool valid() const { return row != 0xFFFF; }
+    };
 }
 
+/// @brief Passes terminal output to the serial port, never more than its TX buffer can take
+class SerialTerminalOutput : public LFAST::TerminalOutput
+{
+public:
+    SerialTerminalOutput(TEST_SERIAL_TYPE *_serial) : serial(_serial) {}
+    size_t write(const char *data, size_t len) override
+    {
+        int room = serial->availableForWrite();
+        if (room <= 0)
+            return 0;
+        if (len > (size_t)room)
+            len = room;
+        return serial->write((const uint8_t *)data, len);
+    }
+
+private:
+    TEST_SERIAL_TYPE *serial;
+};
+
+class TerminalInterface;
+
+/// @brief Runs a console command; args is whatever followed the command name
+typedef void (*CliCommandHandler)(TerminalInterface *cli, const char *args, void *context);
+/// @brief Called by the "reset" command so devices can clear their counters
+typedef void (*CliResetHandler)(void *context);
+
 class TerminalInterface
 {
 protected:
@@ -81,7 +132,10 @@ protected:
     char *rxPtr;
     void handleCliCommand();
     void resetPrompt();
-    std::deque<std::string> debugMessages;
+    // Last MAX_DEBUG_ROWS debug lines, oldest at debugLineHead, kept for repaints
+    char debugLines[LFAST::MAX_DEBUG_ROWS][DEBUG_LINE_CHARS];
+    uint16_t debugLineHead;
+    uint16_t debugLineCount;
 
     struct PersistentTerminalField
     {
@@ -91,10 +145,72 @@ protected:
     };
 
     void initialize();
+    void flushScreen();
+    /// @brief Latest value set for a field; formatted only when it's repainted
+    struct PersistentFieldValue
+    {
+        enum
+        {
+            EMPTY,
+            INT_VALUE,
+            LONG_VALUE,
+            DOUBLE_VALUE,
+            TEXT_VALUE
+        };
+        uint8_t type = EMPTY;
+        bool dirty = false;
+        union
+        {
+            int intVal;
+            long longVal;
+            double doubleVal;
+        };
+        char fmt[PERSISTENT_FIELD_FMT_SIZE] = "";
+        char text[TERMINAL_WIDTH + 1];
+    };
+
+    uint16_t fieldRow(const std::string &device, uint8_t printRow);
+    PersistentFieldValue *fieldValue(uint16_t row);
+    void setFieldText(uint16_t row, const char *text);
+    void repaintFields();
+
+    struct CliCommand
+    {
+        const char *name;
+        const char *help;
+        CliCommandHandler fn;
+        void *context;
+    };
+    std::vector<CliCommand> commands;
+    std::vector<std::pair<CliResetHandler, void *>> resetHandlers;
+    void registerBuiltinCommands();
+
+    // Time between serviceCLI() calls, i.e. the main loop period
+    struct LoopStats
+    {
+        uint32_t count;
+        uint64_t totalUs;
+        uint32_t minUs;
+        uint32_t maxUs;
+    };
+    LoopStats loopStats;
+    uint32_t lastServiceUs;
+    bool loopTimingStarted;
+
+    static void helpCommand(TerminalInterface *cli, const char *args, void *context);
+    static void loopCommand(TerminalInterface *cli, const char *args, void *context);
+    static void heapCommand(TerminalInterface *cli, const char *args, void *context);
+    static void zonesCommand(TerminalInterface *cli, const char *args, void *context);
+    static void resetCommand(TerminalInterface *cli, const char *args, void *context);
+    void queueText(const char *text);
+    void queuef(const char *fmt, ...);
+    void setDebugScrollRegion();
+    void repaintDebugLines();
+    void writeDebugLine(const char *line);
 private:
     uint16_t debugMessageCount;
     uint16_t firstDebugRow = LFAST::NUM_HEADER_ROWS + 1;
-    uint16_t debugRowOffset = 0;
+    uint16_t scrollRegionTop = 0;
 
     uint16_t promptRow;
     uint16_t messageRow;
@@ -104,6 +220,20 @@ private:
     std::map<std::string, uint8_t> senderRowOffsetMap;
     uint16_t highestFieldRowNum;
 
+    // Persistent fields are drawn into this and only the changes are sent, from serviceCLI()
+    LFAST::TerminalScreenBuffer screen;
+    SerialTerminalOutput serialOut;
+    bool cursorAtPrompt;
+
+    // Indexed by terminal row, like the screen buffer
+    std::vector<PersistentFieldValue> fieldValues;
+    bool anyFieldDirty;
+    uint32_t framePeriodMs;
+    uint32_t lastFrameMs;
+
+    LFAST::TerminalOutputQueue txQueue;
+    size_t drainBytesPerCall;
+
 public:
     TerminalInterface(const std::string &, TEST_SERIAL_TYPE *, uint32_t);
 
@@ -111,37 +241,54 @@ public:
     void serviceCLI();
     template <typename... Args>
     void printfDebugMessage(const char *fmt, Args... args);
+    void printDebugMessage(const char *msg, uint8_t level = LFAST::INFO_MESSAGE);
     void printDebugMessage(const std::string &msg, uint8_t level = LFAST::INFO_MESSAGE);
 
     void printHeader();
-    void addPersistentField(const std::string &device, const std::string &label, uint8_t printRow);
+    LFAST::PersistentFieldHandle addPersistentField(const std::string &device, const std::string &label, uint8_t printRow);
     void updatePersistentField(const std::string &device, uint8_t printRow, int fieldVal);
     void updatePersistentField(const std::string &device, uint8_t printRow, long fieldVal);
+    void updatePersistentField(const std::string &device, uint8_t printRow, const char *fieldValStr);
     void updatePersistentField(const std::string &device, uint8_t printRow, const std::string &fieldValStr);
     void updatePersistentField(const std::string &device, uint8_t printRow, double fieldVal, const char *fmt = "%6.4f");
 
+    void updatePersistentField(LFAST::PersistentFieldHandle field, int fieldVal);
+    void updatePersistentField(LFAST::PersistentFieldHandle field, long fieldVal);
+    void updatePersistentField(LFAST::PersistentFieldHandle field, const char *fieldValStr);
+    void updatePersistentField(LFAST::PersistentFieldHandle field, const std::string &fieldValStr);
+    void updatePersistentField(LFAST::PersistentFieldHandle field, double fieldVal, const char *fmt = "%6.4f");
+
     void printPersistentFieldLabels();
 
+    bool registerCommand(const char *name, const char *help, CliCommandHandler fn, void *context = nullptr);
+    void registerResetHandler(CliResetHandler fn, void *context = nullptr);
+    void resetCounters();
+
+    void setOutputBudget(size_t bytesPerCall) { drainBytesPerCall = bytesPerCall; }
+    void setFrameRate(uint32_t hz) { framePeriodMs = (hz > 0) ? 1000 / hz : 0; }
+    size_t pendingOutput() { return txQueue.pending(); }
+    uint32_t droppedOutput() { return txQueue.droppedBytes(); }
+
     // clang-format off
-    inline void clearConsole() {serial->printf("\033[2J"); }
-    inline void clearToEndOfRow() { serial->printf("\033[0K"); }
-    inline void cursorToRowCol(unsigned int row, unsigned int col) { serial->printf("\033[%u;%uH", row+1, col); }
-    inline void cursorToRow(int row) { serial->printf("\033[%u;%uH", (row + 1), 0); }
-    inline void cursorToCol(int col) { serial->printf("\033[%uG", col); }
-
-    inline void red() { serial->printf("\033[31m"); }
-    inline void green() { serial->printf("\033[32m"); }
-    inline void yellow() {serial->printf("\033[33m"); }
-    inline void blue() { serial->printf("\033[34m"); }
-    inline void magenta() { serial->printf("\033[35m"); }
-    inline void cyan() { serial->printf("\033[36m"); }
-    inline void white() { serial->printf("\033[37m"); }
-    inline void reset() { serial->printf("\033[0m"); }
-
-    inline void blinking() { serial->printf("\033[5m"); }
-    inline void notBlinking() { serial->printf("\033[25m"); }
-    inline void hideCursor() { serial->printf("\033[?25l"); }
-    inline void showCursor() { serial->printf("\033[?25h"); }
+    inline void clearConsole() { queueText("\033[2J"); }
+    inline void clearToEndOfRow() { queueText("\033[0K"); }
+    inline void cursorToRowCol(unsigned int row, unsigned int col) { queuef("\033[%u;%uH", row+1, col); }
+    inline void cursorToRow(int row) { queuef("\033[%u;%uH", (row + 1), 0); }
+    inline void cursorToCol(int col) { queuef("\033[%uG", col); }
+
+    inline void red() { queueText("\033[31m"); }
+    inline void green() { queueText("\033[32m"); }
+    inline void yellow() { queueText("\033[33m"); }
+    inline void blue() { queueText("\033[34m"); }
+    inline void magenta() { queueText("\033[35m"); }
+    inline void cyan() { queueText("\033[36m"); }
+    inline void white() { queueText("\033[37m"); }
+    inline void reset() { queueText("\033[0m"); }
+
+    inline void blinking() { queueText("\033[5m"); }
+    inline void notBlinking() { queueText("\033[25m"); }
+    inline void hideCursor() { queueText("\033[?25l"); }
+    inline void showCursor() { queueText("\033[?25h"); }
     // clang-format on
     // void printDebugInfo();
 };
@@ -160,24 +307,5 @@ void TerminalInterface::printfDebugMessage(const char *fmt, Args... args)
 
 int fs_sexa(char *out, double a, int w, int fracbase);
 
-#include <sstream>
-inline std::string debugCodeIdStr(std::string file, int line)
-{
-
-    size_t pos = 0;
-    std::string token;
-    std::string delimiter = "/";
-    while ((pos = file.find(delimiter)) != std::string::npos)
-    {
-        token = file.substr(0, pos);
-        file.erase(0, pos + delimiter.length());
-    }
-
-    std::stringstream ss;
-    ss << file << "[" << line << "]";
-    return ss.str();
-}
-
-#define DEBUG_CODE_ID_STR debugCodeIdStr(__FILE__, __LINE__)
 
 // #endif
\ No newline at end of file
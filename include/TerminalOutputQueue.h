@@ -0,0 +1,66 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file TerminalOutputQueue.h
+/// @brief Ring buffer that terminal output is rendered into
+///
+/// Writes only copy into the ring, so they never wait on the serial port.
+/// drain() hands at most a fixed number of bytes per call to the real output.
+/// A write that doesn't fit is dropped whole (and counted) rather than cut off
+/// partway through an escape sequence. Writes that only make sense together
+/// (a cursor move and the text meant for that spot) go between
+/// beginSequence() and endSequence(), and are dropped together if any of them
+/// doesn't fit. Only meant to be used from the main loop, not from interrupts.
+///
+
+#pragma once
+
+#include "TerminalScreenBuffer.h"
+
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+namespace LFAST
+{
+    class TerminalOutputQueue : public TerminalOutput
+    {
+    public:
+        TerminalOutputQueue(size_t _capacity);
+
+        size_t write(const char *data, size_t len) override;
+        size_t drain(TerminalOutput &sink, size_t maxBytes);
+        void clear();
+        void beginSequence();
+        bool endSequence();
+
+        size_t capacity() { return ring.size(); }
+        size_t pending() { return count; }
+        size_t space() { return ring.size() - count; }
+        uint32_t droppedBytes() { return dropped; }
+
+    private:
+        std::vector<char> ring;
+        size_t head;
+        size_t tail;
+        size_t count;
+        uint32_t dropped;
+
+        bool inSequence;
+        bool sequenceDropped;
+        size_t sequenceHead;
+        size_t sequenceCount;
+    };
+}
@@ -0,0 +1,68 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file TerminalScreenBuffer.h
+/// @brief Shadow copy of the terminal's fixed-position area
+///
+/// Writers only change the back buffer. flush() compares it against the front
+/// buffer (what the terminal is showing) and sends just the cursor moves and
+/// characters that differ, then copies them to the front. Rewriting a value
+/// that hasn't changed costs nothing on the wire. No Arduino dependencies, so
+/// it builds on host.
+///
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+namespace LFAST
+{
+    /// @brief Byte sink for rendered terminal output
+    class TerminalOutput
+    {
+    public:
+        virtual ~TerminalOutput() {}
+        virtual size_t write(const char *data, size_t len) = 0;
+    };
+
+    class TerminalScreenBuffer
+    {
+    public:
+        TerminalScreenBuffer(uint16_t _rows, uint16_t _cols);
+
+        void resize(uint16_t newRows);
+        void put(uint16_t row, uint16_t col, const char *text, bool clearToEol = true);
+        size_t flush(TerminalOutput &out, const char *prefix = nullptr);
+        void markCleared();
+
+        uint16_t rows() { return numRows; }
+        uint16_t cols() { return numCols; }
+        bool dirty() { return anyRowDirty; }
+        char at(uint16_t row, uint16_t col) { return back[index(row, col)]; }
+
+    private:
+        size_t index(uint16_t row, uint16_t col) { return (size_t)row * numCols + col; }
+        size_t emitCursorMove(TerminalOutput &out, uint16_t row, uint16_t col);
+
+        uint16_t numRows;
+        uint16_t numCols;
+        std::vector<char> front;
+        std::vector<char> back;
+        std::vector<uint8_t> rowDirty;
+        bool anyRowDirty;
+    };
+}
@@ -0,0 +1,92 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file UdpCommsService.h
+///
+/// Datagram transport for the LFAST Comms library. Each UDP datagram carries
+/// exactly one message, either JSON or MessagePack (binary), and is dispatched
+/// through the same handler registry as TcpCommsService.
+///
+/// A datagram may carry a top-level "Seq" key. Sequenced datagrams are treated
+/// as setpoint streams with latest-wins semantics: anything older than the
+/// newest sequence number seen from that peer is dropped, and a newer datagram
+/// replaces the values of the keys it carries in datagrams from the same peer
+/// that are still waiting to be processed. Other keys in those are kept.
+/// Datagrams without "Seq" are queued and processed in order like TCP messages.
+///
+/// Peers are tracked per endpoint, up to MAX_UDP_PEERS. A peer that has been
+/// quiet for UDP_PEER_IDLE_TIMEOUT_MS can be evicted to make room for a new
+/// one, and its sequence tracking starts over if it comes back. A sequence
+/// number more than UDP_SEQ_RESYNC_WINDOW behind the newest one is taken as
+/// the sender restarting, not as a stale datagram, and is accepted.
+
+#pragma once
+
+#include <cstdint>
+
+#ifdef TEENSYDUINO
+#include <NativeEthernet.h>
+#include <NativeEthernetUdp.h>
+#else
+#include <SPI.h>
+#include <Ethernet.h>
+#include <EthernetUdp.h>
+#endif
+
+#include "CommService.h"
+#include "TcpCommsService.h"
+
+#define MAX_UDP_PEERS 4
+#define UDP_SEQ_KEY "Seq"
+#ifndef UDP_PEER_IDLE_TIMEOUT_MS
+#define UDP_PEER_IDLE_TIMEOUT_MS 5000U
+#endif
+#ifndef UDP_SEQ_RESYNC_WINDOW
+#define UDP_SEQ_RESYNC_WINDOW 256U
+#endif
+
+namespace LFAST
+{
+    class UdpCommsService : public CommsService
+    {
+    protected:
+        IPAddress ip;
+        EthernetUDP udp;
+        ClientConnection *getDatagramPeer(const IPAddress &, uint16_t);
+        bool acceptSequencedMessage(ClientConnection &, CommsMessageBase *);
+        void sendDatagram(CommsMessageBase &, ClientConnection &);
+
+    public:
+        UdpCommsService(byte *);
+        virtual ~UdpCommsService(){};
+        bool initializeUdpIface(uint16_t);
+
+        bool Status() override { return this->commsServiceStatus; }
+        bool checkForNewClientData() override;
+        void sendMessage(CommsMessageBase &, uint8_t) override;
+    };
+
+    /// @brief Serial number arithmetic so the sequence counter can wrap
+    inline bool seqIsNewer(uint32_t seq, uint32_t prevSeq)
+    {
+        return static_cast<int32_t>(seq - prevSeq) > 0;
+    }
+
+    /// @brief True if seq is far enough behind prevSeq that the sender must have restarted
+    inline bool seqNeedsResync(uint32_t seq, uint32_t prevSeq)
+    {
+        return (prevSeq - seq) > UDP_SEQ_RESYNC_WINDOW && !seqIsNewer(seq, prevSeq);
+    }
+}
@@ -0,0 +1,181 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file cobs_framing.h
+/// @brief Consistent Overhead Byte Stuffing (COBS) frame encoding/decoding
+///
+/// Each frame is COBS encoded so it contains no zero bytes, then terminated
+/// with a single 0x00 delimiter. That matches the '\0' terminator the TCP
+/// transport already uses, and lets a receiver resynchronize at the next
+/// delimiter after line noise. No Arduino dependencies, so it builds on host.
+///
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+namespace LFAST
+{
+    /// @brief Worst case encoded size (not counting the 0x00 delimiter)
+    constexpr size_t cobsMaxEncodedLength(size_t len)
+    {
+        return len + (len / 254) + 1;
+    }
+
+    /// @brief Encodes a buffer. out must hold cobsMaxEncodedLength(len) bytes.
+    /// @return Number of encoded bytes written (not including a delimiter)
+    inline size_t cobsEncode(const uint8_t *in, size_t len, uint8_t *out)
+    {
+        size_t outIdx = 1;
+        size_t codeIdx = 0;
+        uint8_t code = 1;
+        for (size_t ii = 0; ii < len; ii++)
+        {
+            if (in[ii] == 0)
+            {
+                out[codeIdx] = code;
+                codeIdx = outIdx++;
+                code = 1;
+            }
+            else
+            {
+                out[outIdx++] = in[ii];
+                code++;
+                if (code == 0xFF)
+                {
+                    out[codeIdx] = code;
+                    codeIdx = outIdx++;
+                    code = 1;
+                }
+            }
+        }
+        out[codeIdx] = code;
+        return outIdx;
+    }
+
+    /// @brief Decodes one frame (without its delimiter)
+    /// @return Number of decoded bytes, or 0 if the frame is malformed or won't fit
+    inline size_t cobsDecode(const uint8_t *in, size_t len, uint8_t *out, size_t outCapacity)
+    {
+        size_t outIdx = 0;
+        size_t ii = 0;
+        while (ii < len)
+        {
+            uint8_t code = in[ii++];
+            if (code == 0)
+                return 0;
+            for (uint8_t jj = 1; jj < code; jj++)
+            {
+                if (ii >= len || in[ii] == 0 || outIdx >= outCapacity)
+                    return 0;
+                out[outIdx++] = in[ii++];
+            }
+            if (code != 0xFF && ii < len)
+            {
+                if (outIdx >= outCapacity)
+                    return 0;
+                out[outIdx++] = 0;
+            }
+        }
+        return outIdx;
+    }
+
+    /// @brief Incremental COBS decoder for byte streams
+    ///
+    /// Bytes can be fed in arbitrary chunks (e.g. whatever a bulk read returned).
+    /// Decoding happens in place as bytes arrive, so a complete frame is available
+    /// as soon as its delimiter is seen without a second pass. Malformed or
+    /// oversized frames are discarded up to the next delimiter.
+    ///
+    /// @tparam N Maximum decoded frame length
+    template <size_t N>
+    class CobsFrameDecoder
+    {
+    public:
+        CobsFrameDecoder() { reset(); }
+
+        void reset()
+        {
+            frameLen = 0;
+            remaining = 0;
+            pendingZero = false;
+            frameError = false;
+        }
+
+        /// @brief Feeds received bytes through the decoder
+        /// @param onFrame Called as onFrame(const uint8_t *frame, size_t len) for each good frame
+        /// @return Number of complete frames delivered
+        template <typename F>
+        unsigned int feed(const uint8_t *data, size_t len, F onFrame)
+        {
+            unsigned int framesDone = 0;
+            for (size_t ii = 0; ii < len; ii++)
+            {
+                uint8_t b = data[ii];
+                if (b == 0)
+                {
+                    if (!frameError && remaining == 0 && frameLen > 0)
+                    {
+                        onFrame(buffer, frameLen);
+                        framesDone++;
+                    }
+                    else if (frameError || remaining != 0)
+                    {
+                        errorCount++;
+                    }
+                    reset();
+                }
+                else if (frameError)
+                {
+                    continue;
+                }
+                else if (remaining == 0)
+                {
+                    // New code byte
+                    if (pendingZero)
+                        append(0);
+                    remaining = b - 1;
+                    pendingZero = (b != 0xFF);
+                }
+                else
+                {
+                    append(b);
+                    remaining--;
+                }
+            }
+            return framesDone;
+        }
+
+        /// @brief Number of frames dropped for being malformed or too long
+        unsigned int errors() { return errorCount; }
+
+    private:
+        void append(uint8_t b)
+        {
+            if (frameLen >= N)
+                frameError = true;
+            else
+                buffer[frameLen++] = b;
+        }
+
+        uint8_t buffer[N];
+        size_t frameLen;
+        uint8_t remaining;
+        bool pendingZero;
+        bool frameError;
+        unsigned int errorCount = 0;
+    };
+}
@@ -86,13 +86,13 @@ T DF2_IIR<T>::update(T x_n)
     T &v_n = v.front();
     v_n = x_n;
 
-    for (int ii = 1; ii < a.size(); ii++)
+    for (size_t ii = 1; ii < a.size(); ii++)
     {
         v_n -= a.at(ii) * v.at(ii);
     }
 
     T y_n = 0;
-    for (int ii = 0; ii < b.size(); ii++)
+    for (size_t ii = 0; ii < b.size(); ii++)
     {
         T b_ii = b.at(ii);
         T v_cur = v.at(ii);
@@ -100,4 +100,76 @@ T DF2_IIR<T>::update(T x_n)
     }
 
     return y_n;
-}
\ No newline at end of file
+}
+/// @brief Direct form II IIR filter with the order fixed at compile time
+///
+/// Same difference equation as DF2_IIR, but coefficients and delay line are
+/// plain arrays inside the object, so it never touches the heap and can be
+/// embedded in a controller. Coefficients can be given as any type T can be
+/// constructed from (e.g. the double tables above for a float filter).
+template <typename T, unsigned int ORDER>
+class StaticDF2_IIR
+{
+    static_assert(ORDER > 0, "StaticDF2_IIR needs at least one pole");
+
+public:
+    StaticDF2_IIR()
+    {
+        for (unsigned int ii = 0; ii < ORDER + 1; ii++)
+        {
+            b[ii] = T(0);
+            a[ii] = T(0);
+        }
+        a[0] = T(1);
+        reset();
+    }
+
+    template <typename C>
+    StaticDF2_IIR(const C *_b, const C *_a) : StaticDF2_IIR()
+    {
+        configure(_b, _a);
+    }
+
+    /// @brief Loads new coefficients; rejected (filter left as it was) unless a[0] == 1
+    /// Doesn't throw, so it's usable with -fno-exceptions.
+    template <typename C>
+    bool configure(const C *_b, const C *_a)
+    {
+        if (_a[0] != 1)
+            return false;
+        for (unsigned int ii = 0; ii < ORDER + 1; ii++)
+        {
+            b[ii] = T(_b[ii]);
+            a[ii] = T(_a[ii]);
+        }
+        return true;
+    }
+
+    void reset()
+    {
+        for (unsigned int ii = 0; ii < ORDER; ii++)
+            v[ii] = T(0);
+    }
+
+    T update(T x_n)
+    {
+        // v[0] is v(n-1), v[1] is v(n-2), ...
+        T v_n = x_n;
+        for (unsigned int ii = 1; ii < ORDER + 1; ii++)
+            v_n -= a[ii] * v[ii - 1];
+
+        T y_n = b[0] * v_n;
+        for (unsigned int ii = 1; ii < ORDER + 1; ii++)
+            y_n += b[ii] * v[ii - 1];
+
+        for (unsigned int ii = ORDER - 1; ii > 0; ii--)
+            v[ii] = v[ii - 1];
+        v[0] = v_n;
+        return y_n;
+    }
+
+private:
+    T b[ORDER + 1];
+    T a[ORDER + 1];
+    T v[ORDER];
+};
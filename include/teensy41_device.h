@@ -19,7 +19,9 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
 #include "macro.h"
+#if defined(ARDUINO)
 #include <Arduino.h>
+#endif
 
 #ifdef DEVICE_LABEL
 #define DEVICE_CLI_LABEL STR(DEVICE_LABEL)
@@ -59,7 +61,11 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 
 
 
-#if defined(TEST_SERIAL_NO)
+#if !defined(ARDUINO)
+    // Host builds (tests, benchmarks) talk to file descriptors instead
+    #include "HostSerial.h"
+    #define TEST_SERIAL_TYPE HostSerial
+#elif defined(TEST_SERIAL_NO)
     #define TEST_SERIAL_TYPE HardwareSerial
     #if TEST_SERIAL_NO==1
         #define TEST_SERIAL_RX_PIN 0
@@ -0,0 +1,89 @@
+# decode_log.py
+#
+# Turns a drained deferred log (see include/DeferredLog.h) back into text,
+# using the table from make_format_table.py. Reads a file or stdin; if the
+# log was captured mid-stream it skips ahead to the next record.
+#
+#   python decode_log.py deferred_log_table.json log.bin
+#   cat /dev/ttyACM1 | python decode_log.py deferred_log_table.json -
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+HEADER = struct.Struct("<BBII")
+ARG_FORMATS = {"i": "<i", "u": "<I", "q": "<q", "Q": "<Q", "d": "<d"}
+# printf conversions; Python's % takes the same ones without length modifiers
+CONVERSION_RE = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|j|z|t|L)?([diouxXeEfFgGcsp%])")
+
+def python_format(fmt):
+    def fix(m):
+        flags, conv = m.group(1), m.group(2)
+        if conv == "u":
+            conv = "d"
+        elif conv == "p":
+            flags, conv = "#" + flags, "x"
+        return "%" + flags + conv
+    return CONVERSION_RE.sub(fix, fmt)
+
+def parse_args(payload):
+    args = []
+    pos = 0
+    while pos < len(payload):
+        tag = chr(payload[pos])
+        pos += 1
+        if tag == "s":
+            length = payload[pos]
+            args.append(payload[pos + 1:pos + 1 + length].decode("latin-1"))
+            pos += 1 + length
+        elif tag in ARG_FORMATS:
+            fmt = struct.Struct(ARG_FORMATS[tag])
+            args.append(fmt.unpack_from(payload, pos)[0])
+            pos += fmt.size
+        else:
+            raise ValueError(f"unknown argument tag {tag!r}")
+    return args
+
+def records(data):
+    pos = 0
+    while pos + HEADER.size <= len(data):
+        sync, argBytes, fmtId, timestampUs = HEADER.unpack_from(data, pos)
+        end = pos + HEADER.size + argBytes
+        if sync != SYNC or end > len(data):
+            pos += 1
+            continue
+        try:
+            args = parse_args(data[pos + HEADER.size:end])
+        except (ValueError, struct.error, IndexError):
+            pos += 1
+            continue
+        yield timestampUs, fmtId, args
+        pos = end
+
+def format_record(table, fmtId, args):
+    fmt = table.get(f"0x{fmtId:08X}")
+    if fmt is None:
+        return f"<unknown format 0x{fmtId:08X}> {args}"
+    try:
+        return python_format(fmt) % tuple(args)
+    except (TypeError, ValueError):
+        return f"{fmt!r} {args}"
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Decode a deferred binary log")
+    parser.add_argument("table", help="JSON table from make_format_table.py")
+    parser.add_argument("log", help="Log file, or - for stdin")
+    args = parser.parse_args()
+    with open(args.table) as f:
+        table = json.load(f)
+    if args.log == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.log, "rb") as f:
+            data = f.read()
+    for timestampUs, fmtId, fmtArgs in records(data):
+        text = format_record(table, fmtId, fmtArgs).rstrip("\r\n")
+        print(f"{timestampUs / 1e6:12.6f}  {text}")
@@ -0,0 +1,79 @@
+# make_format_table.py
+#
+# Builds the format table for deferred logs (see include/DeferredLog.h). Scans
+# the given source files/directories for DEFERRED_LOG(log, "format", ...)
+# calls and writes a JSON map from each format's FNV-1a ID to the format
+# string. Run it as part of the build so the table always matches the firmware.
+#
+#   python make_format_table.py src include -o deferred_log_table.json
+
+import argparse
+import json
+import os
+import re
+import sys
+
+SOURCE_EXTS = (".c", ".cc", ".cpp", ".h", ".hpp", ".ino")
+# The format is one or more adjacent string literals
+CALL_RE = re.compile(r'DEFERRED_LOG\s*\([^,]+,\s*((?:"(?:[^"\\]|\\.)*"\s*)+)')
+LITERAL_RE = re.compile(r'"((?:[^"\\]|\\.)*)"')
+ESCAPES = {"n": "\n", "r": "\r", "t": "\t", "\\": "\\", '"': '"', "'": "'", "0": "\0", "a": "\a", "b": "\b"}
+
+def unescape(literal):
+    out = []
+    ii = 0
+    while ii < len(literal):
+        c = literal[ii]
+        if c == "\\" and ii + 1 < len(literal):
+            nxt = literal[ii + 1]
+            if nxt == "x":
+                m = re.match(r"[0-9a-fA-F]+", literal[ii + 2:])
+                out.append(chr(int(m.group(0), 16)))
+                ii += 2 + len(m.group(0))
+                continue
+            out.append(ESCAPES.get(nxt, nxt))
+            ii += 2
+            continue
+        out.append(c)
+        ii += 1
+    return "".join(out)
+
+def fnv1a(text):
+    h = 2166136261
+    for b in text.encode("latin-1"):
+        h ^= b
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+def source_files(paths):
+    for path in paths:
+        if os.path.isfile(path):
+            yield path
+            continue
+        for root, _, files in os.walk(path):
+            for name in files:
+                if name.endswith(SOURCE_EXTS):
+                    yield os.path.join(root, name)
+
+def build_table(paths):
+    table = {}
+    for path in source_files(paths):
+        with open(path, encoding="utf-8", errors="replace") as f:
+            text = f.read()
+        for call in CALL_RE.finditer(text):
+            fmt = "".join(unescape(lit) for lit in LITERAL_RE.findall(call.group(1)))
+            key = f"0x{fnv1a(fmt):08X}"
+            if key in table and table[key] != fmt:
+                print(f"warning: {key} collides: {table[key]!r} / {fmt!r}", file=sys.stderr)
+            table[key] = fmt
+    return table
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Build the deferred log format table")
+    parser.add_argument("paths", nargs="+", help="Source files or directories to scan")
+    parser.add_argument("-o", "--output", default="deferred_log_table.json")
+    args = parser.parse_args()
+    table = build_table(args.paths)
+    with open(args.output, "w") as f:
+        json.dump(table, f, indent=2, sort_keys=True)
+    print(f"{len(table)} formats written to {args.output}")
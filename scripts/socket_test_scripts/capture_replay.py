@@ -0,0 +1,144 @@
+# capture_replay.py
+#
+# Plays a frame capture (see include/FrameCapture.h) back at a device, so
+# recorded production traffic can be used as a repeatable benchmark workload.
+# Each captured connection gets its own socket, so per-connection ordering and
+# interleaving are preserved. Frames go out either with their original timing
+# (--mode realtime) or back to back (--mode max). To replay without a device,
+# through the library's own framers and dispatcher, see test/capture_replay_bench.cc.
+#
+# TCP links are JSON text split by brace counting, so a capture holding
+# MessagePack frames (from a serial or UDP link) can only be replayed over UDP.
+#
+#   python capture_replay.py capture.bin --dump
+#   python capture_replay.py capture.bin --host 192.168.121.177 --mode max
+
+import socket
+import struct
+import time
+import argparse
+
+HOST = "192.168.121.177"
+# HOST = "localhost"
+TCP_PORT = 1883
+UDP_PORT = 4401
+
+FILE_HEADER = struct.Struct("<5sBH")
+RECORD_HEADER = struct.Struct("<IHH")
+FORMAT_VERSION = 1
+
+def read_capture(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, version, _ = FILE_HEADER.unpack_from(data, 0)
+    if magic != b"LFCAP" or version != FORMAT_VERSION:
+        raise SystemExit(f"{path} is not a version {FORMAT_VERSION} frame capture")
+    pos = FILE_HEADER.size
+    records = []
+    while pos + RECORD_HEADER.size <= len(data):
+        timestampUs, connId, length = RECORD_HEADER.unpack_from(data, pos)
+        pos += RECORD_HEADER.size
+        if pos + length > len(data):
+            break
+        records.append((timestampUs, connId, data[pos:pos + length]))
+        pos += length
+    return records
+
+def is_json(payload):
+    # Same test the device uses (CommsMessageBase::setInputLength)
+    return len(payload) > 0 and payload[0] in b"{ \r\n\t"
+
+def elapsed_us(records):
+    # Timestamps are micros() and wrap every ~71 minutes
+    t0 = records[0][0]
+    return [((ts - t0) & 0xFFFFFFFF) for ts, _, _ in records]
+
+class TcpReplay:
+    def __init__(self, host, port):
+        self.host, self.port = host, port
+        self.socks = {}
+
+    def send(self, connId, payload):
+        s = self.socks.get(connId)
+        if s is None:
+            s = socket.create_connection((self.host, self.port))
+            s.setblocking(False)
+            self.socks[connId] = s
+        s.sendall(payload + b"\0")
+        try:
+            s.recv(65536)  # replies aren't checked, just kept from backing up
+        except BlockingIOError:
+            pass
+
+    def close(self):
+        for s in self.socks.values():
+            s.close()
+
+class UdpReplay:
+    def __init__(self, host, port):
+        self.addr = (host, port)
+        self.socks = {}
+
+    def send(self, connId, payload):
+        s = self.socks.get(connId)
+        if s is None:
+            s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            s.setblocking(False)
+            self.socks[connId] = s
+        s.sendto(payload, self.addr)
+        try:
+            s.recv(65536)
+        except BlockingIOError:
+            pass
+
+    def close(self):
+        for s in self.socks.values():
+            s.close()
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument("capture")
+    parser.add_argument("--host", default=HOST)
+    parser.add_argument("--port", type=int, default=None)
+    parser.add_argument("--transport", choices=("tcp", "udp"), default="tcp")
+    parser.add_argument("--mode", choices=("realtime", "max"), default="realtime")
+    parser.add_argument("--conn", type=int, default=None, help="only replay this captured connection id")
+    parser.add_argument("--dump", action="store_true", help="print the records instead of sending them")
+    args = parser.parse_args()
+
+    records = read_capture(args.capture)
+    if args.conn is not None:
+        records = [r for r in records if r[1] == args.conn]
+    if not records:
+        raise SystemExit("no records to replay")
+
+    if args.dump:
+        for offset, (_, connId, payload) in zip(elapsed_us(records), records):
+            print(f"{offset / 1e6:12.6f}  conn {connId:5d}  {len(payload):5d} B  {payload[:80]!r}")
+        raise SystemExit(0)
+
+    if args.transport == "tcp":
+        binary = sum(1 for r in records if not is_json(r[2]))
+        if binary:
+            raise SystemExit(f"{binary} of {len(records)} frames are MessagePack, which TCP can't carry; "
+                             "replay with --transport udp or pick a JSON connection with --conn")
+        replay = TcpReplay(args.host, args.port or TCP_PORT)
+    else:
+        replay = UdpReplay(args.host, args.port or UDP_PORT)
+
+    offsets = elapsed_us(records)
+    totalBytes = 0
+    start = time.perf_counter()
+    for offset, (_, connId, payload) in zip(offsets, records):
+        if args.mode == "realtime":
+            delay = start + offset / 1e6 - time.perf_counter()
+            if delay > 0:
+                time.sleep(delay)
+        replay.send(connId, payload)
+        totalBytes += len(payload)
+    duration = time.perf_counter() - start
+    replay.close()
+
+    captured = offsets[-1] / 1e6
+    print(f"{len(records)} frames, {totalBytes} bytes in {duration:.3f} s "
+          f"({len(records) / duration:.1f} frames/s, captured over {captured:.3f} s)")
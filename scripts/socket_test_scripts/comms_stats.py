@@ -0,0 +1,56 @@
+# comms_stats.py
+#
+# Asks a device for its CommsService counters (reserved "GetCommsStats" key)
+# and prints them, optionally polling. Use the DocPeak/DocCapacity and queue
+# peaks to size the message classes and MAX_CTRL_MESSAGES for a deployment.
+
+import socket
+import json
+import time
+import argparse
+
+HOST = "192.168.121.177"
+# HOST = "localhost"
+PORT = 1883
+
+default_timeout = 3
+
+def query(s):
+    s.sendall((json.dumps({"GetCommsStats": 0}) + "\0").encode('utf-8'))
+    rxBuff = b''
+    while b'\0' not in rxBuff:
+        data = s.recv(4096)
+        if not data:
+            raise ConnectionError("connection closed")
+        rxBuff += data
+    frame = rxBuff.split(b'\0', 1)[0]
+    return json.loads(frame.decode('utf-8'))["CommsStats"]
+
+def print_stats(stats):
+    print(f"bytes in/out:      {stats['BytesIn']} / {stats['BytesOut']}")
+    print(f"frames in/out:     {stats['FramesIn']} / {stats['FramesOut']}")
+    print(f"dropped/parse/trunc: {stats['Dropped']} / {stats['ParseErrors']} / {stats['Truncated']}")
+    print(f"coalesced values:  {stats['Coalesced']}")
+    print(f"rx queue peak:     {stats['RxQueuePeak']}")
+    for name, peak, cap in zip(("small", "medium", "large"), stats["DocPeak"], stats["DocCapacity"]):
+        print(f"doc peak {name:6s}:   {peak} / {cap}")
+    print(f"arena peak:        {stats['ArenaPeak']} ({stats['ArenaFallbacks']} fallbacks)")
+    for ii, link in enumerate(stats["Links"]):
+        print(f"  link {ii}: {json.dumps(link)}")
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--host", default=HOST)
+    parser.add_argument("--port", type=int, default=PORT)
+    parser.add_argument("--period", type=float, default=0, help="poll every PERIOD seconds (0 = once)")
+    args = parser.parse_args()
+
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
+        s.settimeout(default_timeout)
+        s.connect((args.host, args.port))
+        while True:
+            print_stats(query(s))
+            if args.period <= 0:
+                break
+            time.sleep(args.period)
+            print()
@@ -0,0 +1,80 @@
+# pmc_json_pipelined.py
+#
+# Sends many requests over a single connection without waiting for each reply,
+# then matches the replies back up using CorrelationId. Compares against the
+# one-request-at-a-time pattern the other scripts use.
+
+import socket
+import json
+import time
+import argparse
+
+HOST = "192.168.121.177"
+# HOST = "localhost"
+PORT = 1883
+
+default_timeout = 3
+
+def send(s, msg):
+    s.sendall((json.dumps(msg) + "\0").encode('utf-8'))
+
+class ReplyReader:
+    def __init__(self, s):
+        self.s = s
+        self.rxBuff = b''
+
+    def next(self):
+        while b'\0' not in self.rxBuff:
+            data = self.s.recv(4096)
+            if not data:
+                raise ConnectionError("connection closed")
+            self.rxBuff += data
+        frame, self.rxBuff = self.rxBuff.split(b'\0', 1)
+        return json.loads(frame.decode('utf-8'))
+
+def handshake(corrId):
+    return {"PMCMessage": {"Handshake": 0xDEAD}, "CorrelationId": corrId}
+
+def run_sequential(s, reader, count):
+    start = time.perf_counter()
+    for corrId in range(count):
+        send(s, handshake(corrId))
+        reply = reader.next()
+        assert reply.get("CorrelationId") == corrId, reply
+    return time.perf_counter() - start
+
+def run_pipelined(s, reader, count, window):
+    outstanding = set()
+    nextId = 0
+    done = 0
+    start = time.perf_counter()
+    while done < count:
+        while nextId < count and len(outstanding) < window:
+            send(s, handshake(nextId))
+            outstanding.add(nextId)
+            nextId += 1
+        reply = reader.next()
+        corrId = reply.get("CorrelationId")
+        if corrId not in outstanding:
+            raise RuntimeError(f"unexpected reply: {reply}")
+        outstanding.remove(corrId)
+        done += 1
+    return time.perf_counter() - start
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--host", default=HOST)
+    parser.add_argument("--port", type=int, default=PORT)
+    parser.add_argument("--count", type=int, default=200)
+    parser.add_argument("--window", type=int, default=16, help="max requests in flight")
+    args = parser.parse_args()
+
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
+        s.connect((args.host, args.port))
+        s.settimeout(default_timeout)
+        reader = ReplyReader(s)
+        seqTime = run_sequential(s, reader, args.count)
+        pipeTime = run_pipelined(s, reader, args.count, args.window)
+
+    print(f"sequential: {args.count / seqTime:8.1f} req/s")
+    print(f"pipelined:  {args.count / pipeTime:8.1f} req/s (window {args.window})")
@@ -0,0 +1,72 @@
+# udp-echo-server.py
+#
+# Host stand-in for UdpCommsService so the datagram protocol can be tested on
+# loopback without a Teensy. Mirrors the device's rules:
+#  - one JSON (or MessagePack, if the msgpack module is installed) message per datagram
+#  - datagrams with a top-level "Seq" key are setpoints: anything not newer than
+#    the last accepted Seq from that peer is dropped
+#  - replies are stamped with the server's own outgoing "Seq" per peer
+
+import socket
+import json
+import argparse
+
+try:
+    import msgpack
+except ImportError:
+    msgpack = None
+
+HOST = "localhost"
+PORT = 4401
+
+def seq_is_newer(seq, prev_seq):
+    diff = (seq - prev_seq) & 0xFFFFFFFF
+    return diff != 0 and diff < 0x80000000
+
+def decode(data):
+    if data[:1] in (b'{', b' ', b'\r', b'\n', b'\t'):
+        return json.loads(data.decode('utf-8')), False
+    if msgpack is None:
+        raise ValueError("binary datagram received but msgpack isn't installed")
+    return msgpack.unpackb(data), True
+
+def encode(msg, binary):
+    if binary:
+        return msgpack.packb(msg)
+    return json.dumps(msg).encode('utf-8')
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--host", default=HOST)
+    parser.add_argument("--port", type=int, default=PORT)
+    parser.add_argument("--quiet", action="store_true")
+    args = parser.parse_args()
+
+    peers = {}
+    accepted = 0
+    dropped = 0
+    with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as server:
+        server.bind((args.host, args.port))
+        print(f"Listening on {args.host}:{args.port}")
+        while True:
+            data, addr = server.recvfrom(2048)
+            msg, binary = decode(data)
+            peer = peers.setdefault(addr, {"rxSeq": None, "txSeq": 0})
+
+            if "Seq" in msg:
+                seq = msg.pop("Seq")
+                if peer["rxSeq"] is not None and not seq_is_newer(seq, peer["rxSeq"]):
+                    dropped += 1
+                    if not args.quiet:
+                        print(f"Dropped stale Seq {seq} from {addr} (last {peer['rxSeq']})")
+                    continue
+                peer["rxSeq"] = seq
+            accepted += 1
+
+            if not args.quiet:
+                print(f"{addr}: {msg}  [accepted {accepted}, dropped {dropped}]")
+
+            # Echo the message back the way the device would reply
+            msg["Seq"] = peer["txSeq"]
+            peer["txSeq"] = (peer["txSeq"] + 1) & 0xFFFFFFFF
+            server.sendto(encode(msg, binary), addr)
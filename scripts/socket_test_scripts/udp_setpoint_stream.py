@@ -0,0 +1,75 @@
+# udp_setpoint_stream.py
+#
+# Streams sequenced setpoint datagrams to a UdpCommsService device (or to
+# udp-echo-server.py on loopback) and reports how many replies came back.
+# --reorder swaps neighbouring datagrams so the stale-drop path gets exercised.
+
+import socket
+import json
+import time
+import math
+import argparse
+
+try:
+    import msgpack
+except ImportError:
+    msgpack = None
+
+# HOST = "192.168.121.177"
+HOST = "localhost"
+PORT = 4401
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--host", default=HOST)
+    parser.add_argument("--port", type=int, default=PORT)
+    parser.add_argument("--count", type=int, default=1000)
+    parser.add_argument("--rate", type=float, default=500.0, help="datagrams per second (0 = as fast as possible)")
+    parser.add_argument("--reorder", action="store_true")
+    parser.add_argument("--binary", action="store_true", help="send MessagePack instead of JSON")
+    args = parser.parse_args()
+
+    if args.binary and msgpack is None:
+        raise SystemExit("--binary needs the msgpack module")
+
+    def encode(msg):
+        if args.binary:
+            return msgpack.packb(msg)
+        return json.dumps(msg).encode('utf-8')
+
+    datagrams = []
+    for seq in range(args.count):
+        tipRad = 0.01 * math.sin(seq * 0.01)
+        datagrams.append(encode({"Seq": seq, "PMCMessage": {"SetTip": tipRad, "MoveType": 1}}))
+    if args.reorder:
+        for ii in range(0, len(datagrams) - 1, 8):
+            datagrams[ii], datagrams[ii + 1] = datagrams[ii + 1], datagrams[ii]
+
+    period = 1.0 / args.rate if args.rate > 0 else 0.0
+    replies = 0
+    with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as s:
+        s.setblocking(False)
+        start = time.perf_counter()
+        nextSend = start
+        for dgram in datagrams:
+            s.sendto(dgram, (args.host, args.port))
+            nextSend += period
+            while True:
+                try:
+                    s.recv(2048)
+                    replies += 1
+                except BlockingIOError:
+                    pass
+                if time.perf_counter() >= nextSend:
+                    break
+        # Give the last replies a moment to arrive
+        s.settimeout(0.25)
+        try:
+            while True:
+                s.recv(2048)
+                replies += 1
+        except (TimeoutError, socket.timeout):
+            pass
+        elapsed = time.perf_counter() - start
+
+    print(f"Sent {args.count} datagrams in {elapsed:.3f} s ({args.count / elapsed:.0f}/s), {replies} replies")
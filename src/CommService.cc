@@ -29,6 +29,8 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 #include "teensy41_device.h"
 
 std::vector<LFAST::ClientConnection> LFAST::CommsService::connections{};
+LFAST::CommsStats LFAST::CommsService::commsStats{};
+LFAST::FrameCaptureWriter *LFAST::CommsService::captureWriter = nullptr;
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////// PUBLIC FUNCTIONS ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -37,11 +39,13 @@ LFAST::CommsService::CommsService()
     activeConnection = nullptr;
 }
 
-void LFAST::CommsService::setupClientMessageBuffers(Client *client)
+void LFAST::CommsService::setupClientMessageBuffers(Client *client, bool framed)
 {
     // ClientConnection is created on the stack
-    ClientConnection newConnection(client);
+    ClientConnection newConnection(client, framed);
     this->connections.push_back(newConnection);
+    // Size the queues up front so steady state operation doesn't allocate
+    this->connections.back().rxMessageQueue.reserve(MAX_CTRL_MESSAGES);
 }
 
 void LFAST::CommsService::defaultMessageHandler(const char *info)
@@ -52,7 +56,7 @@ void LFAST::CommsService::defaultMessageHandler(const char *info)
     }
 }
 
-void LFAST::CommsService::errorMessageHandler(CommsMessage &msg)
+void LFAST::CommsService::errorMessageHandler(CommsMessageBase &msg)
 {
     if (cli != nullptr)
     {
@@ -77,9 +81,12 @@ bool LFAST::CommsService::checkForNewClientData()
     // check for incoming data from all clients
     for (auto &connection : this->connections)
     {
+        if (connection.isDatagramPeer() || connection.framedLink)
+            continue;
         if (connection.client->available())
         {
-            newMsgFlag = getNewMessages(connection);
+            if (getNewMessages(connection))
+                newMsgFlag = true;
         }
     }
     return newMsgFlag;
@@ -92,11 +99,13 @@ bool LFAST::CommsService::getNewMessages(ClientConnection &connection)
     //     cli->updatePersistentField(DeviceName, COMMS_SERVICE_STATUS_ROW, "getNewMessages()");
     // listen for incoming clients
     Client *client = connection.client;
+    bool newMsgFlag = false;
     if (client)
     {
-        auto newMsg = new CommsMessage();
+        // Frames are staged here until their length (and so their message class) is known
+        static char rxStaging[LARGE_MSG_BUFF_SIZE];
         unsigned int bytesRead = 0;
-        bool readingObject = false, objectDone = false;
+        bool readingObject = false, objectDone = false, overflow = false;
         int openObjectsCnt = 0;
 
         while (client->connected())
@@ -104,7 +113,10 @@ bool LFAST::CommsService::getNewMessages(ClientConnection &connection)
             if (client->available())
             {
                 char c = client->read();
-                newMsg->jsonInputBuffer[bytesRead++] = c;
+                if (bytesRead < sizeof(rxStaging) - 1)
+                    rxStaging[bytesRead++] = c;
+                else
+                    overflow = true;
                 if (c == '{')
                 {
                     if (!readingObject)
@@ -120,25 +132,51 @@ bool LFAST::CommsService::getNewMessages(ClientConnection &connection)
                 }
                 if (objectDone)
                 {
-                    newMsg->jsonInputBuffer[bytesRead + 1] = '\0';
+                    auto newMsg = overflow ? nullptr : CommsMessageBase::newForLength(bytesRead);
+                    recordRx(&connection, bytesRead, newMsg != nullptr);
+                    if (newMsg == nullptr)
+                    {
+#if defined(TERMINAL_ENABLED)
+                        if (cli != nullptr)
+                            cli->printDebugMessage("Dropped oversized message.", LFAST::WARNING_MESSAGE);
+#endif
+                        break;
+                    }
+                    captureFrame(&connection, rxStaging, bytesRead);
+                    std::memcpy(newMsg->jsonInputBuffer, rxStaging, bytesRead);
+                    newMsg->jsonInputBuffer[bytesRead] = '\0';
                     if (cli != nullptr)
                     {
-                        cli->updatePersistentField(DeviceName, RAW_MESSAGE_RECEIVED_ROW, newMsg->jsonInputBuffer);
+                        cli->updatePersistentField(infoFields[RAW_MESSAGE_RECEIVED_ROW], newMsg->jsonInputBuffer);
                     }
                     connection.rxMessageQueue.push_back(newMsg);
+                    newMsgFlag = true;
                     break;
                 }
             }
         }
     }
-    return true;
+    return newMsgFlag;
+}
+
+/// @brief Allocates the smallest message class whose input buffer holds len bytes
+/// @return nullptr if the payload is larger than LARGE_MSG_BUFF_SIZE allows
+LFAST::CommsMessageBase *LFAST::CommsMessageBase::newForLength(size_t len)
+{
+    if (len < SMALL_MSG_BUFF_SIZE)
+        return new SmallCommsMessage();
+    if (len < MEDIUM_MSG_BUFF_SIZE)
+        return new MediumCommsMessage();
+    if (len < LARGE_MSG_BUFF_SIZE)
+        return new LargeCommsMessage();
+    return nullptr;
 }
 
-void LFAST::CommsMessage::printMessageInfo(TerminalInterface *debugCli)
+void LFAST::CommsMessageBase::printMessageInfo(TerminalInterface *debugCli)
 {
     if (debugCli != nullptr)
     {
-        debugCli->printfDebugMessage("MESSAGE ID: %u\033[0K\r\n", (unsigned int)this->getBuffPtr());
+        debugCli->printfDebugMessage("MESSAGE ID: %u\033[0K\r\n", (unsigned int)(uintptr_t)this->getBuffPtr());
         debugCli->printDebugMessage("MESSAGE Input Buffer: \033[0K");
 
         // bool nullTermFound = false;
@@ -160,13 +198,21 @@ void LFAST::CommsMessage::printMessageInfo(TerminalInterface *debugCli)
     }
 }
 
-void LFAST::CommsService::processClientData(const char *destFilter = "")
+void LFAST::CommsService::processClientData(const char *destFilter)
 {
     // if (cli != nullptr)
     //     cli->updatePersistentField(DeviceName, COMMS_SERVICE_STATUS_ROW, "processClientData()");
+    bool anyProcessed = false;
     for (auto &conn : this->connections)
     {
         this->activeConnection = &conn;
+        // The queue only grows between calls, so this is where it peaks. There is no
+        // tx peak to track: sendMessage() writes straight to the link.
+        conn.stats.rxQueuePeak = std::max(conn.stats.rxQueuePeak, conn.rxMessageQueue.size());
+        commsStats.totals.rxQueuePeak = std::max(commsStats.totals.rxQueuePeak, conn.rxMessageQueue.size());
+        anyProcessed = anyProcessed || !conn.rxMessageQueue.empty();
+
+        coalesceStateKeys(conn, destFilter);
         auto itr = conn.rxMessageQueue.begin();
         while (itr != conn.rxMessageQueue.end())
         {
@@ -176,9 +222,19 @@ void LFAST::CommsService::processClientData(const char *destFilter = "")
         }
     }
     // this->activeConnection = nullptr;
+
+#if defined(TERMINAL_ENABLED)
+    if (anyProcessed)
+        updateStatsFields();
+#else
+    (void)anyProcessed;
+#endif
+
+    // Everything received this tick has been handled, so rewind the message arena
+    JsonArena::reset();
 }
 
-void LFAST::CommsService::processMessage(CommsMessage *msg, const char *destFilter)
+void LFAST::CommsService::processMessage(CommsMessageBase *msg, const char *destFilter)
 {
     // if (cli != nullptr)
     //     cli->updatePersistentField(DeviceName, COMMS_SERVICE_STATUS_ROW, "processMessage()");
@@ -190,35 +246,231 @@ void LFAST::CommsService::processMessage(CommsMessage *msg, const char *destFilt
         }
         return;
     }
-    if (cli != nullptr)
+    if (cli != nullptr && !msg->isBinary())
+    {
+        if (msg->isDeserialized())
+        {
+            // Parsed ahead of time (sequence check, coalescing), so the input text is
+            // gone; show what is left to dispatch instead
+            char displayBuff[TERMINAL_WIDTH + 1];
+            serializeJson(msg->getJsonDoc(), displayBuff, sizeof(displayBuff));
+            cli->updatePersistentField(infoFields[PROCESSED_MESSAGE_ROW], displayBuff);
+        }
+        else
+        {
+            cli->updatePersistentField(infoFields[PROCESSED_MESSAGE_ROW], msg->jsonInputBuffer);
+        }
+    }
+    JsonDocument &doc = msg->deserialize();
+    recordDocUsage(*msg);
+    if (msg->parseFailed())
     {
-        cli->updatePersistentField(DeviceName, PROCESSED_MESSAGE_ROW, msg->jsonInputBuffer);
+        commsStats.totals.parseErrors++;
+        if (activeConnection != nullptr)
+            activeConnection->stats.parseErrors++;
     }
-    DynamicJsonDocument &doc = msg->deserialize();
     JsonObject msgRoot = doc.as<JsonObject>();
+    takeCorrelationId(msgRoot);
 
     // Test if parsing succeeds.
     if (strlen(destFilter) > 0)
+    {
         msgRoot = msgRoot[destFilter];
-    for (JsonPair kvp : msgRoot)
+        takeCorrelationId(msgRoot);
+        dispatchObject(defaultHandlers, msgRoot);
+    }
+    else
     {
-        this->callMessageHandler(kvp);
+        // One pass over the top level: routed destination objects go to their
+        // own registry, everything else to the default one.
+        for (JsonPair kvp : msgRoot)
+        {
+            auto route = routingTable.find(kvp.key().c_str());
+            if (route != routingTable.end() && kvp.value().is<JsonObject>())
+            {
+                JsonObject destObj = kvp.value().as<JsonObject>();
+                takeCorrelationId(destObj);
+                dispatchObject(route->second, destObj);
+            }
+            else if (std::strcmp(kvp.key().c_str(), COMMS_STATS_KEY) == 0)
+            {
+                sendCommsStats();
+            }
+            else
+            {
+                this->callMessageHandler(kvp);
+            }
+        }
+        defaultHandlers.finishStructs();
     }
 
+    // Replies sent after this point aren't answering this request
+    if (activeConnection != nullptr)
+        activeConnection->hasCorrelationId = false;
+
     // memset(msg->jsonInputBuffer, 0, JSON_PROGMEM_SIZE);
     msg->setProcessedFlag();
 }
 
+/// @brief Pulls the correlation ID (if any) out of a request so it isn't dispatched as a key
+///
+/// The ID is held on the active connection while the request's handlers run,
+/// and any reply they send through ACTIVE_CONNECTION is stamped with it.
+///
+/// @param obj Object that may hold CORRELATION_ID_KEY
+void LFAST::CommsService::takeCorrelationId(JsonObject obj)
+{
+    if (obj.isNull() || activeConnection == nullptr)
+        return;
+    JsonVariant idVar = obj[CORRELATION_ID_KEY];
+    if (idVar.isNull())
+        return;
+    activeConnection->correlationId = idVar.as<uint32_t>();
+    activeConnection->hasCorrelationId = true;
+    obj.remove(CORRELATION_ID_KEY);
+}
+
+/// @brief Adds the connection's pending correlation ID to an outgoing reply
+void LFAST::CommsService::stampCorrelationId(CommsMessageBase &msg, ClientConnection &conn)
+{
+    if (conn.hasCorrelationId)
+        msg.getJsonDoc()[CORRELATION_ID_KEY] = conn.correlationId;
+}
+
+/// @brief Marks a key as state (latest value wins) or event (every value delivered)
+///
+/// When several queued messages set the same state key, processClientData()
+/// only dispatches the newest value. Don't mark keys that belong to a struct
+/// schema; a record missing a required field isn't delivered.
+void LFAST::CommsService::setKeySemantics(const char *key, uint8_t semantics)
+{
+    defaultHandlers.setKeySemantics(key, semantics);
+}
+
+void LFAST::CommsService::setKeySemantics(const char *destKey, const char *key, uint8_t semantics)
+{
+    getRoute(destKey).setKeySemantics(key, semantics);
+}
+
+void LFAST::MessageHandlerRegistry::setKeySemantics(const char *key, uint8_t semantics)
+{
+    if (semantics == STATE_KEY)
+        stateKeys[key] = semantics;
+    else
+        stateKeys.erase(key);
+}
+
+/// @brief Drops state key values that a newer queued message overrides
+///
+/// Walks the queue newest to oldest, so each message is only parsed once
+/// (processMessage() reuses the parse) and a backlog costs one pass.
+void LFAST::CommsService::coalesceStateKeys(ClientConnection &conn, const char *destFilter)
+{
+    if (conn.rxMessageQueue.size() < 2)
+        return;
+    bool anyStateKeys = defaultHandlers.hasStateKeys();
+    for (auto &route : routingTable)
+        anyStateKeys = anyStateKeys || route.second.hasStateKeys();
+    if (!anyStateKeys)
+        return;
+
+    seenStateKeys.clear();
+    for (auto itr = conn.rxMessageQueue.rbegin(); itr != conn.rxMessageQueue.rend(); itr++)
+    {
+        JsonObject msgRoot = (*itr)->deserialize(cli).as<JsonObject>();
+        if (strlen(destFilter) > 0)
+        {
+            pruneStateKeys(defaultHandlers, destFilter, msgRoot[destFilter]);
+            continue;
+        }
+        pruneStateKeys(defaultHandlers, "", msgRoot);
+        for (JsonPair kvp : msgRoot)
+        {
+            auto route = routingTable.find(kvp.key().c_str());
+            if (route != routingTable.end() && kvp.value().is<JsonObject>())
+                pruneStateKeys(route->second, kvp.key().c_str(), kvp.value().as<JsonObject>());
+        }
+    }
+}
+
+/// @brief Removes state keys from obj that were already seen in a newer message, and records the rest
+/// @param scope Destination key the object sits under ("" for the top level)
+void LFAST::CommsService::pruneStateKeys(MessageHandlerRegistry &registry, const char *scope, JsonObject obj)
+{
+    if (obj.isNull() || !registry.hasStateKeys())
+        return;
+
+    // Collect first; removing members while iterating the object isn't safe
+    staleStateKeys.clear();
+    for (JsonPair kvp : obj)
+    {
+        const char *key = kvp.key().c_str();
+        if (!registry.isStateKey(key))
+            continue;
+        bool seen = false;
+        for (auto &prev : seenStateKeys)
+        {
+            if (std::strcmp(prev.first, scope) == 0 && std::strcmp(prev.second, key) == 0)
+            {
+                seen = true;
+                break;
+            }
+        }
+        if (seen)
+            staleStateKeys.push_back(key);
+        else
+            seenStateKeys.emplace_back(scope, key);
+    }
+    for (auto key : staleStateKeys)
+        obj.remove(key);
+    commsStats.coalescedValues += staleStateKeys.size();
+}
+
+/// @brief Returns the handler registry for a destination key, creating it if needed
+///
+/// Once a destination has a route, processClientData() with no filter hands
+/// that key's object to the route's registry, so several devices sharing one
+/// connection are all served from a single parse of each message.
+///
+/// @param destKey Top level key, e.g. "PMCMessage"
+LFAST::MessageHandlerRegistry &LFAST::CommsService::getRoute(const char *destKey)
+{
+    return routingTable[destKey];
+}
+
+void LFAST::CommsService::dispatchObject(MessageHandlerRegistry &registry, JsonObject obj)
+{
+    for (JsonPair kvp : obj)
+    {
+        if (std::strcmp(kvp.key().c_str(), COMMS_STATS_KEY) == 0)
+            sendCommsStats();
+        else if (!registry.callMessageHandler(kvp))
+            defaultMessageHandler(kvp.key().c_str());
+    }
+    registry.finishStructs();
+}
+
 bool LFAST::CommsService::callMessageHandler(JsonPair kvp)
 {
-    // if (cli != nullptr)
-    //     cli->updatePersistentField(DeviceName, COMMS_SERVICE_STATUS_ROW, "callMessageHandler()");
+    bool handlerFound = defaultHandlers.callMessageHandler(kvp);
+    if (!handlerFound)
+        defaultMessageHandler(kvp.key().c_str());
+    return handlerFound;
+}
+
+/// @brief Calls the handler registered for a key, converting the value to the handler's type
+/// @return false if no handler is registered for the key
+bool LFAST::MessageHandlerRegistry::callMessageHandler(JsonPair kvp)
+{
     bool handlerFound = true;
     auto keyStr = kvp.key().c_str();
-    if (this->handlerTypes.find(keyStr) == this->handlerTypes.end())
+    if (!this->structFields.empty() && storeStructField(keyStr, kvp.value()))
+    {
+        handlerFound = true;
+    }
+    else if (this->handlerTypes.find(keyStr) == this->handlerTypes.end())
     {
         handlerFound = false;
-        defaultMessageHandler(keyStr);
     }
     else
     {
@@ -243,6 +495,7 @@ bool LFAST::CommsService::callMessageHandler(JsonPair kvp)
             auto val = kvp.value().as<float>();
             this->callMessageHandler<float>(keyStr, val);
         }
+        break;
         case DOUBLE_HANDLER:
         {
             auto val = kvp.value().as<double>();
@@ -261,6 +514,21 @@ bool LFAST::CommsService::callMessageHandler(JsonPair kvp)
             this->callMessageHandler<const char *>(keyStr, val);
         }
         break;
+        case INT_ARRAY_HANDLER:
+            this->callArrayHandler<int>(keyStr, kvp.value());
+            break;
+        case FLOAT_ARRAY_HANDLER:
+            this->callArrayHandler<float>(keyStr, kvp.value());
+            break;
+        case DOUBLE_ARRAY_HANDLER:
+            this->callArrayHandler<double>(keyStr, kvp.value());
+            break;
+        case VECTOR_HANDLER:
+        {
+            auto &vh = this->vectorHandlers[keyStr];
+            vh.thunk(vh.fn, kvp.value().as<JsonArray>());
+        }
+        break;
         default:
             handlerFound = false;
         }
@@ -269,12 +537,61 @@ bool LFAST::CommsService::callMessageHandler(JsonPair kvp)
     return handlerFound;
 }
 
-void LFAST::CommsService::sendMessage(CommsMessage &msg, uint8_t sendOpt)
+/// @brief Decodes a value into the struct record whose schema holds the key
+/// @return false if no registered struct has this key
+bool LFAST::MessageHandlerRegistry::storeStructField(const char *key, JsonVariant val)
+{
+    auto ref = this->structFields.find(key);
+    if (ref == this->structFields.end())
+        return false;
+
+    StructBinding &binding = structBindings[ref->second.binding];
+    const StructField &field = binding.fields[ref->second.field];
+    uint8_t *dest = static_cast<uint8_t *>(binding.record.get()) + field.offset;
+    switch (field.type)
+    {
+    case INT_FIELD:
+        *reinterpret_cast<int *>(dest) = val.as<int>();
+        break;
+    case UINT_FIELD:
+        *reinterpret_cast<unsigned int *>(dest) = val.as<unsigned int>();
+        break;
+    case FLOAT_FIELD:
+        *reinterpret_cast<float *>(dest) = val.as<float>();
+        break;
+    case DOUBLE_FIELD:
+        *reinterpret_cast<double *>(dest) = val.as<double>();
+        break;
+    case BOOL_FIELD:
+        *reinterpret_cast<bool *>(dest) = val.as<bool>();
+        break;
+    }
+    binding.presentMask |= (1UL << ref->second.field);
+    return true;
+}
+
+/// @brief Delivers every struct record that got all its required fields, then clears them all
+///
+/// Called once the pass over an object is done.
+void LFAST::MessageHandlerRegistry::finishStructs()
+{
+    for (auto &binding : structBindings)
+    {
+        if (binding.presentMask == 0)
+            continue;
+        if ((binding.presentMask & binding.requiredMask) == binding.requiredMask)
+            binding.deliver(binding.fn, binding.record.get(), binding.presentMask);
+        std::memset(binding.record.get(), 0, binding.recordSize);
+        binding.presentMask = 0;
+    }
+}
+
+void LFAST::CommsService::sendMessage(CommsMessageBase &msg, uint8_t sendOpt)
 {
 #if defined(TERMINAL_ENABLED)
     static int callCount = 0;
     if (cli != nullptr)
-        cli->updatePersistentField(DeviceName, COMMS_SERVICE_STATUS_ROW, callCount++);
+        cli->updatePersistentField(infoFields[COMMS_SERVICE_STATUS_ROW], callCount++);
 #endif
     if (sendOpt == ACTIVE_CONNECTION)
     {
@@ -288,12 +605,13 @@ void LFAST::CommsService::sendMessage(CommsMessage &msg, uint8_t sendOpt)
 #endif
             return;
         }
+        stampCorrelationId(msg, *activeConnection);
 #if defined(TERMINAL_ENABLED)
         if (cli != nullptr)
         {
             char msgBuff[JSON_PROGMEM_SIZE]{0};
             msg.getMessageStr(msgBuff);
-            cli->updatePersistentField(DeviceName, MESSAGE_SENT_ROW, msgBuff);
+            cli->updatePersistentField(infoFields[MESSAGE_SENT_ROW], msgBuff);
         }
 #endif
         if (activeConnection->client)
@@ -301,12 +619,14 @@ void LFAST::CommsService::sendMessage(CommsMessage &msg, uint8_t sendOpt)
 #define USE_BUFFERED_CLIENT 1
 #if USE_BUFFERED_CLIENT == 1
             auto sz = measureJson(msg.getJsonDoc());
+            recordTx(activeConnection, msg, sz + 1);
             auto chunkSize = sz < 64 ? sz : 64;
             WriteBufferingStream bufferedClient{*(activeConnection->client), chunkSize};
             serializeJson(msg.getJsonDoc(), bufferedClient);
             bufferedClient.flush();
             activeConnection->client->write('\0');
 #else
+            recordTx(activeConnection, msg, measureJson(msg.getJsonDoc()) + 1);
             serializeJson(msg.getJsonDoc(), *(activeConnection->client));
             activeConnection->client->write('\0');
             // cli->printDebugMessage("Done sending (unbuff'd)");
@@ -322,21 +642,31 @@ void LFAST::CommsService::sendMessage(CommsMessage &msg, uint8_t sendOpt)
     }
 }
 
-DynamicJsonDocument &LFAST::CommsMessage::deserialize(TerminalInterface *debugCli)
+JsonDocument &LFAST::CommsMessageBase::deserialize(TerminalInterface *debugCli)
 {
+    if (this->deserialized)
+    {
+        return this->JsonDoc;
+    }
     if (this->jsonInputBuffer != nullptr)
     {
+        DeserializationError error;
+        if (this->msgPackFormat)
+            error = deserializeMsgPack(this->JsonDoc, this->jsonInputBuffer, this->inputLength);
+        else
+            error = deserializeJson(this->JsonDoc, this->jsonInputBuffer);
+        this->deserialized = true;
+        this->parseError = (bool)error;
 #if defined(TERMINAL_ENABLED)
-        DeserializationError error = deserializeJson(this->JsonDoc, this->jsonInputBuffer);
         if (error)
         {
             if (debugCli != nullptr)
             {
-                debugCli->printfDebugMessage("deserializeJson() failed: %s", error.c_str());
+                debugCli->printfDebugMessage("deserialize failed: %s", error.c_str());
             }
         }
 #else
-        deserializeJson(this->JsonDoc, this->jsonInputBuffer);
+        (void)error;
 #endif
     }
     else
@@ -352,12 +682,10 @@ DynamicJsonDocument &LFAST::CommsMessage::deserialize(TerminalInterface *debugCl
     return this->JsonDoc;
 }
 
-void LFAST::CommsMessage::getMessageStr(char *buff)
+void LFAST::CommsMessageBase::getMessageStr(char *buff)
 {
     // TEST_SERIAL.println("getMessageStr");
-    DynamicJsonDocument docCopy(JSON_PROGMEM_SIZE);
-    docCopy = this->JsonDoc;
-    serializeJson(docCopy, buff, JSON_PROGMEM_SIZE);
+    serializeJson(this->JsonDoc, buff, JSON_PROGMEM_SIZE);
 }
 
 void LFAST::CommsService::stopDisconnectedClients()
@@ -367,7 +695,12 @@ void LFAST::CommsService::stopDisconnectedClients()
     auto itr = connections.begin();
     while (itr != connections.end())
     {
-        if (!(*itr).client->connected())
+        // Datagram peers have no connection state to lose
+        if ((*itr).isDatagramPeer())
+        {
+            itr++;
+        }
+        else if (!(*itr).client->connected())
         {
             (*itr).client->stop();
             itr = connections.erase(itr);
@@ -379,16 +712,16 @@ void LFAST::CommsService::stopDisconnectedClients()
     }
 }
 
-// void LFAST::CommsMessage::startArray()
+// void LFAST::CommsMessageBase::startArray()
 // {
 //     msgIsArray = true;
 
 // }
 
-// void LFAST::CommsMessage::endArray()
+// void LFAST::CommsMessageBase::endArray()
 // {
 // }
-// void LFAST::CommsMessage::convertToArray()
+// void LFAST::CommsMessageBase::convertToArray()
 // {
 //     DynamicJsonDocument(JSON_PROGMEM_SIZE)
 //     JsonArray array = JsonDoc.to<JsonArray>();
@@ -398,13 +731,202 @@ void LFAST::CommsService::setupPersistentFields()
 {
     if (cli == nullptr)
         return;
-    cli->addPersistentField(this->DeviceName, "[STATUS]", COMMS_SERVICE_STATUS_ROW);
+    infoFields[COMMS_SERVICE_STATUS_ROW] = cli->addPersistentField(this->DeviceName, "[STATUS]", COMMS_SERVICE_STATUS_ROW);
+
+    infoFields[RAW_MESSAGE_RECEIVED_ROW] = cli->addPersistentField(this->DeviceName, "[RAW RX]", RAW_MESSAGE_RECEIVED_ROW);
+
+    infoFields[PROCESSED_MESSAGE_ROW] = cli->addPersistentField(this->DeviceName, "[PROCESSED RX]", PROCESSED_MESSAGE_ROW);
 
-    cli->addPersistentField(this->DeviceName, "[RAW RX]", RAW_MESSAGE_RECEIVED_ROW);
+    infoFields[MESSAGE_SENT_ROW] = cli->addPersistentField(this->DeviceName, "[TX]", MESSAGE_SENT_ROW);
 
-    cli->addPersistentField(this->DeviceName, "[PROCESSED RX]", PROCESSED_MESSAGE_ROW);
+    infoFields[COMMS_TRAFFIC_ROW] = cli->addPersistentField(this->DeviceName, "[BYTES IN/OUT]", COMMS_TRAFFIC_ROW);
 
-    cli->addPersistentField(this->DeviceName, "[TX]", MESSAGE_SENT_ROW);
+    infoFields[COMMS_ERRORS_ROW] = cli->addPersistentField(this->DeviceName, "[DROP/PARSE/TRUNC]", COMMS_ERRORS_ROW);
+
+    infoFields[COMMS_QUEUE_PEAK_ROW] = cli->addPersistentField(this->DeviceName, "[RX QUEUE PEAK]", COMMS_QUEUE_PEAK_ROW);
+
+    infoFields[COMMS_DOC_PEAK_ROW] = cli->addPersistentField(this->DeviceName, "[DOC PEAK S/M/L]", COMMS_DOC_PEAK_ROW);
+
+    // Stats are shared by every service, so the first one to get here registers the command
+    if (cli->registerCommand("comms", "Comms traffic, queue depths and drops", commsCommand))
+        cli->registerResetHandler(resetCommsStats);
+}
+
+/// @brief Console command: prints the comms totals and each link's queues
+void LFAST::CommsService::commsCommand(TerminalInterface *cli, const char *, void *)
+{
+    const CommsLinkStats &totals = commsStats.totals;
+    cli->printfDebugMessage("Comms: in %lu B / %lu frames, out %lu B / %lu frames",
+                            (unsigned long)totals.bytesIn, (unsigned long)totals.framesIn,
+                            (unsigned long)totals.bytesOut, (unsigned long)totals.framesOut);
+    cli->printfDebugMessage("Comms: dropped %lu, parse errors %lu, truncated %lu, coalesced %lu",
+                            (unsigned long)totals.droppedFrames, (unsigned long)totals.parseErrors,
+                            (unsigned long)commsStats.truncatedMessages, (unsigned long)commsStats.coalescedValues);
+    for (size_t ii = 0; ii < connections.size(); ii++)
+    {
+        ClientConnection &conn = connections[ii];
+        cli->printfDebugMessage("Link %u: rx queue %u (peak %u), dropped %lu",
+                                (unsigned int)ii, (unsigned int)conn.rxMessageQueue.size(),
+                                (unsigned int)conn.stats.rxQueuePeak, (unsigned long)conn.stats.droppedFrames);
+    }
+}
+
+/// @brief Reset handler for the console's "reset" command
+void LFAST::CommsService::resetCommsStats(void *)
+{
+    commsStats = CommsStats{};
+    for (auto &conn : connections)
+        conn.stats = CommsLinkStats{};
+}
+
+/// @brief Records every frame received by any CommsService into a capture
+///
+/// The sink has to stay alive until stopCapture(). Captures can be replayed
+/// against a device with scripts/socket_test_scripts/capture_replay.py.
+void LFAST::CommsService::startCapture(CaptureSink &sink)
+{
+    stopCapture();
+    captureWriter = new FrameCaptureWriter(sink);
+}
+
+/// @brief Flushes and ends the current capture
+void LFAST::CommsService::stopCapture()
+{
+    if (captureWriter == nullptr)
+        return;
+    captureWriter->flush();
+#if defined(TERMINAL_ENABLED)
+    if (cli != nullptr)
+        cli->printfDebugMessage("Capture stopped: %u frames, %u write errors",
+                                captureWriter->records(), captureWriter->errors());
+#endif
+    delete captureWriter;
+    captureWriter = nullptr;
+}
+
+void LFAST::CommsService::captureFrame(ClientConnection *conn, const void *data, size_t len)
+{
+    if (captureWriter == nullptr)
+        return;
+    uint16_t connId = (conn != nullptr) ? conn->id : 0xFFFF;
+    captureWriter->record(micros(), connId, static_cast<const uint8_t *>(data), len);
+}
+
+/// @brief Counts a received frame
+/// @param conn Connection it arrived on, or nullptr if it couldn't be attributed to one
+/// @param bytes Payload length
+/// @param accepted false if the frame was dropped before reaching a queue
+void LFAST::CommsService::recordRx(ClientConnection *conn, size_t bytes, bool accepted)
+{
+    commsStats.totals.bytesIn += bytes;
+    if (accepted)
+        commsStats.totals.framesIn++;
+    else
+        commsStats.totals.droppedFrames++;
+    if (conn == nullptr)
+        return;
+    conn->stats.bytesIn += bytes;
+    if (accepted)
+        conn->stats.framesIn++;
+    else
+        conn->stats.droppedFrames++;
+}
+
+/// @brief Counts an outgoing message
+/// @param bytes Bytes written, or 0 if the message couldn't be sent
+void LFAST::CommsService::recordTx(ClientConnection *conn, CommsMessageBase &msg, size_t bytes)
+{
+    recordDocUsage(msg);
+    CommsLinkStats *linkStats = (conn != nullptr) ? &conn->stats : nullptr;
+    if (bytes == 0)
+    {
+        commsStats.totals.droppedFrames++;
+        if (linkStats != nullptr)
+            linkStats->droppedFrames++;
+        return;
+    }
+    commsStats.totals.bytesOut += bytes;
+    commsStats.totals.framesOut++;
+    if (linkStats != nullptr)
+    {
+        linkStats->bytesOut += bytes;
+        linkStats->framesOut++;
+    }
+}
+
+/// @brief Tracks the JSON pool high-water mark for the message's size class
+void LFAST::CommsService::recordDocUsage(CommsMessageBase &msg)
+{
+    size_t &peak = commsStats.peakDocUsage[msg.getSizeClass()];
+    peak = std::max(peak, msg.getJsonDoc().memoryUsage());
+    if (msg.isTruncated())
+        commsStats.truncatedMessages++;
+}
+
+/// @brief Replies to COMMS_STATS_KEY with the service totals and one entry per connection
+///
+/// The reply is a large message, so it comes from the JSON arena rather than
+/// sitting on the stack underneath the dispatch loop.
+void LFAST::CommsService::sendCommsStats()
+{
+    LargeCommsMessage *replyPtr = new LargeCommsMessage();
+    LargeCommsMessage &reply = *replyPtr;
+    JsonObject stats = reply.getJsonDoc().createNestedObject("CommsStats");
+    const CommsLinkStats &totals = commsStats.totals;
+    stats["BytesIn"] = totals.bytesIn;
+    stats["BytesOut"] = totals.bytesOut;
+    stats["FramesIn"] = totals.framesIn;
+    stats["FramesOut"] = totals.framesOut;
+    stats["Dropped"] = totals.droppedFrames;
+    stats["ParseErrors"] = totals.parseErrors;
+    stats["Truncated"] = commsStats.truncatedMessages;
+    stats["Coalesced"] = commsStats.coalescedValues;
+    stats["RxQueuePeak"] = totals.rxQueuePeak;
+
+    JsonArray docPeak = stats.createNestedArray("DocPeak");
+    JsonArray docCapacity = stats.createNestedArray("DocCapacity");
+    for (unsigned int ii = 0; ii < NUM_MESSAGE_CLASSES; ii++)
+        docPeak.add(commsStats.peakDocUsage[ii]);
+    docCapacity.add(SMALL_MSG_DOC_SIZE);
+    docCapacity.add(MEDIUM_MSG_DOC_SIZE);
+    docCapacity.add(LARGE_MSG_DOC_SIZE);
+    stats["ArenaPeak"] = JsonArena::highWaterMark();
+    stats["ArenaFallbacks"] = JsonArena::fallbackAllocations();
+
+    JsonArray links = stats.createNestedArray("Links");
+    for (auto &conn : this->connections)
+    {
+        JsonObject link = links.createNestedObject();
+        link["BytesIn"] = conn.stats.bytesIn;
+        link["BytesOut"] = conn.stats.bytesOut;
+        link["Dropped"] = conn.stats.droppedFrames;
+        link["ParseErrors"] = conn.stats.parseErrors;
+        link["RxQueuePeak"] = conn.stats.rxQueuePeak;
+    }
+    sendMessage(reply, ACTIVE_CONNECTION);
+    delete replyPtr;
+}
+
+void LFAST::CommsService::updateStatsFields()
+{
+    if (cli == nullptr)
+        return;
+    const CommsLinkStats &totals = commsStats.totals;
+    char fieldBuff[64];
+    snprintf(fieldBuff, sizeof(fieldBuff), "%lu / %lu",
+             (unsigned long)totals.bytesIn, (unsigned long)totals.bytesOut);
+    cli->updatePersistentField(infoFields[COMMS_TRAFFIC_ROW], fieldBuff);
+    snprintf(fieldBuff, sizeof(fieldBuff), "%lu / %lu / %lu",
+             (unsigned long)totals.droppedFrames, (unsigned long)totals.parseErrors,
+             (unsigned long)commsStats.truncatedMessages);
+    cli->updatePersistentField(infoFields[COMMS_ERRORS_ROW], fieldBuff);
+    snprintf(fieldBuff, sizeof(fieldBuff), "%u", (unsigned int)totals.rxQueuePeak);
+    cli->updatePersistentField(infoFields[COMMS_QUEUE_PEAK_ROW], fieldBuff);
+    snprintf(fieldBuff, sizeof(fieldBuff), "%u/%u %u/%u %u/%u",
+             (unsigned int)commsStats.peakDocUsage[SMALL_MESSAGE_CLASS], (unsigned int)SMALL_MSG_DOC_SIZE,
+             (unsigned int)commsStats.peakDocUsage[MEDIUM_MESSAGE_CLASS], (unsigned int)MEDIUM_MSG_DOC_SIZE,
+             (unsigned int)commsStats.peakDocUsage[LARGE_MESSAGE_CLASS], (unsigned int)LARGE_MSG_DOC_SIZE);
+    cli->updatePersistentField(infoFields[COMMS_DOC_PEAK_ROW], fieldBuff);
 }
 // void LFAST::CommsService::updateStatusFields()
 // {
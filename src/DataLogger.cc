@@ -0,0 +1,126 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+///
+
+#include "../include/DataLogger.h"
+
+#include <cstring>
+
+/// @param _sink Where the log goes; has to outlive the logger
+/// @param _recordSize Bytes per record (e.g. sizeof a telemetry struct). A
+/// size of 0 or more than DATA_LOG_BUFFER_SIZE leaves the logger closed, so
+/// every log() call is dropped and nothing is written.
+LFAST::DataLogger::DataLogger(CaptureSink &_sink, uint16_t _recordSize)
+    : sink(_sink), recSize(_recordSize), active(0), activeLen(0), fullLen(0), fullWritten(0),
+      closed(false), logged(0), dropped(0), blocks(0), errors(0)
+{
+    if (recSize == 0 || recSize > DATA_LOG_BUFFER_SIZE)
+    {
+        closed = true;
+        return;
+    }
+    uint8_t header[DATA_LOG_HEADER_SIZE] = {'L', 'F', 'L', 'O', 'G', DATA_LOG_FORMAT_VERSION, 0,
+                                            (uint8_t)(recSize & 0xFF), (uint8_t)(recSize >> 8)};
+    append(header, sizeof(header));
+}
+
+/// @brief Copies one record into the RAM buffers
+/// @return false if the record was dropped because both buffers are full
+bool LFAST::DataLogger::log(const void *record)
+{
+    if (closed || !append((const uint8_t *)record, recSize))
+    {
+        dropped++;
+        return false;
+    }
+    logged++;
+    return true;
+}
+
+/// @brief Copies bytes into the active buffer, moving on to the other one if it fills
+///
+/// Data is only accepted if it leaves the last free buffer with room to spare:
+/// filling it would swap again and overwrite the buffer still waiting for service().
+bool LFAST::DataLogger::append(const uint8_t *data, size_t len)
+{
+    size_t room = DATA_LOG_BUFFER_SIZE - activeLen;
+    if (fullLen == 0)
+        room += DATA_LOG_BUFFER_SIZE;
+    if (len >= room)
+        return false;
+
+    while (len > 0)
+    {
+        size_t chunk = DATA_LOG_BUFFER_SIZE - activeLen;
+        if (chunk > len)
+            chunk = len;
+        std::memcpy(&buffers[active][activeLen], data, chunk);
+        activeLen += chunk;
+        data += chunk;
+        len -= chunk;
+        if (activeLen == DATA_LOG_BUFFER_SIZE)
+            swapBuffers();
+    }
+    return true;
+}
+
+/// @brief Hands the active buffer over to service() and starts on the other one
+void LFAST::DataLogger::swapBuffers()
+{
+    fullLen = activeLen;
+    fullWritten = 0;
+    active ^= 1;
+    activeLen = 0;
+}
+
+/// @brief Writes part of the full buffer, if there is one
+/// @param maxBlocks Most blocks to write in this call
+/// @return Number of blocks written
+size_t LFAST::DataLogger::service(size_t maxBlocks)
+{
+    size_t written = 0;
+    const uint8_t *full = buffers[active ^ 1];
+    while (fullLen > 0 && written < maxBlocks)
+    {
+        size_t len = fullLen - fullWritten;
+        if (len > DATA_LOG_BLOCK_SIZE)
+            len = DATA_LOG_BLOCK_SIZE;
+        if (!sink.write(full + fullWritten, len))
+            errors++;
+        fullWritten += len;
+        written++;
+        blocks++;
+        if (fullWritten == fullLen)
+            fullLen = 0;
+    }
+    return written;
+}
+
+/// @brief Writes everything still buffered (blocking) and flushes the sink
+void LFAST::DataLogger::close()
+{
+    if (closed)
+        return;
+    while (fullLen > 0)
+        service(DATA_LOG_BUFFER_BLOCKS);
+    if (activeLen > 0)
+    {
+        swapBuffers();
+        service(DATA_LOG_BUFFER_BLOCKS);
+    }
+    sink.flush();
+    closed = true;
+}
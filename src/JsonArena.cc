@@ -0,0 +1,161 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file JsonArena.cc
+///
+
+#include "../include/JsonArena.h"
+
+#include <cstdlib>
+#include <cstring>
+
+// Every block is prefixed with its size so reallocate() knows how much to copy,
+// and with the space it takes in the arena so reset() can walk the blocks
+struct BlockHeader
+{
+    size_t size;
+    size_t span; // aligned payload size, plus BLOCK_LIVE while in use
+};
+constexpr size_t BLOCK_ALIGN = 8;
+constexpr size_t BLOCK_LIVE = 1; // spans are multiples of BLOCK_ALIGN, so bit 0 is free
+
+alignas(BLOCK_ALIGN) uint8_t LFAST::JsonArena::pool[JSON_ARENA_SIZE];
+size_t LFAST::JsonArena::head = 0;
+size_t LFAST::JsonArena::highWater = 0;
+unsigned int LFAST::JsonArena::liveCount = 0;
+unsigned int LFAST::JsonArena::fallbackCount = 0;
+
+static inline size_t alignUp(size_t n)
+{
+    return (n + BLOCK_ALIGN - 1) & ~(BLOCK_ALIGN - 1);
+}
+
+static inline BlockHeader *headerOf(void *ptr)
+{
+    return reinterpret_cast<BlockHeader *>(static_cast<uint8_t *>(ptr) - sizeof(BlockHeader));
+}
+
+static inline size_t spanOf(const BlockHeader *hdr)
+{
+    return hdr->span & ~BLOCK_LIVE;
+}
+
+bool LFAST::JsonArena::owns(void *ptr)
+{
+    uint8_t *p = static_cast<uint8_t *>(ptr);
+    return (p >= pool) && (p < pool + JSON_ARENA_SIZE);
+}
+
+/// @brief Bumps a block off the arena, or mallocs one if the arena is full
+void *LFAST::JsonArena::allocate(size_t size)
+{
+    size_t blockSize = sizeof(BlockHeader) + alignUp(size);
+    void *ptr;
+    if (head + blockSize > JSON_ARENA_SIZE)
+    {
+        uint8_t *block = static_cast<uint8_t *>(std::malloc(blockSize));
+        if (block == nullptr)
+            return nullptr;
+        fallbackCount++;
+        ptr = block + sizeof(BlockHeader);
+    }
+    else
+    {
+        ptr = pool + head + sizeof(BlockHeader);
+        head += blockSize;
+        if (head > highWater)
+            highWater = head;
+    }
+    headerOf(ptr)->size = size;
+    headerOf(ptr)->span = alignUp(size) | BLOCK_LIVE;
+    liveCount++;
+    return ptr;
+}
+
+/// @brief Arena blocks are only marked free and reclaimed by reset(); fallback blocks are freed
+void LFAST::JsonArena::deallocate(void *ptr)
+{
+    if (ptr == nullptr)
+        return;
+    if (liveCount > 0)
+        liveCount--;
+    if (owns(ptr))
+        headerOf(ptr)->span &= ~BLOCK_LIVE;
+    else
+        std::free(headerOf(ptr));
+}
+
+void *LFAST::JsonArena::reallocate(void *ptr, size_t newSize)
+{
+    if (ptr == nullptr)
+        return allocate(newSize);
+
+    BlockHeader *hdr = headerOf(ptr);
+    if (owns(ptr))
+    {
+        uint8_t *blockEnd = static_cast<uint8_t *>(ptr) + spanOf(hdr);
+        bool isNewest = (blockEnd == pool + head);
+        // Shrinking is always safe in place; the newest block can also grow in place
+        if (newSize <= hdr->size)
+        {
+            if (isNewest)
+            {
+                head -= spanOf(hdr) - alignUp(newSize);
+                hdr->span = alignUp(newSize) | BLOCK_LIVE;
+            }
+            hdr->size = newSize;
+            return ptr;
+        }
+        if (isNewest && (head - spanOf(hdr) + alignUp(newSize) <= JSON_ARENA_SIZE))
+        {
+            head += alignUp(newSize) - spanOf(hdr);
+            if (head > highWater)
+                highWater = head;
+            hdr->size = newSize;
+            hdr->span = alignUp(newSize) | BLOCK_LIVE;
+            return ptr;
+        }
+    }
+
+    void *newPtr = allocate(newSize);
+    if (newPtr != nullptr)
+    {
+        std::memcpy(newPtr, ptr, hdr->size < newSize ? hdr->size : newSize);
+        deallocate(ptr);
+    }
+    return newPtr;
+}
+
+/// @brief Rewinds the arena to the end of the newest block still in use
+///
+/// Call once per loop tick, after the received messages have been processed.
+/// A message kept across ticks only pins the arena up to its own block: every
+/// block after it is reclaimed, and the ones before it are once it is freed.
+///
+/// @return true if the arena is now empty
+bool LFAST::JsonArena::reset()
+{
+    size_t pos = 0;
+    size_t liveEnd = 0;
+    while (pos < head)
+    {
+        const BlockHeader *hdr = reinterpret_cast<const BlockHeader *>(pool + pos);
+        pos += sizeof(BlockHeader) + spanOf(hdr);
+        if (hdr->span & BLOCK_LIVE)
+            liveEnd = pos;
+    }
+    head = liveEnd;
+    return head == 0;
+}
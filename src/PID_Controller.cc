@@ -23,32 +23,38 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 //////////////////////////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////////////////////////
-PID_Controller::PID_Controller(double _kp, double _ki, double _kd) : Kp(_kp),
-                                                                     Ki(_ki),
-                                                                     Kd(_kd),
-                                                                     limit_integrator(false),
-                                                                     limit_output(false),
-                                                                     outputSaturatedFlag(false),
-                                                                     e_prev(0)
+template <typename T>
+PID_ControllerT<T>::PID_ControllerT(T _kp, T _ki, T _kd) : Kp(_kp),
+                                                          Ki(_ki),
+                                                          Kd(_kd),
+                                                          Kb(0),
+                                                          limit_integrator(false),
+                                                          limit_output(false),
+                                                          filter_derivative(false),
+                                                          outputSaturatedFlag(false),
+                                                          e_prev(0)
 {
     configureCompMode();
+    reset();
 }
 //////////////////////////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////////////////////////
-void PID_Controller::configureCompMode()
+template <typename T>
+void PID_ControllerT<T>::configureCompMode()
 {
     uint8_t compMode = 0;
-    compMode |= Kp != 0 ? DIGITAL_CONTROL::P_BIT : 0;
-    compMode |= Ki != 0 ? DIGITAL_CONTROL::I_BIT : 0;
-    compMode |= Kd != 0 ? DIGITAL_CONTROL::D_BIT : 0;
+    compMode |= Kp != T(0) ? DIGITAL_CONTROL::P_BIT : 0;
+    compMode |= Ki != T(0) ? DIGITAL_CONTROL::I_BIT : 0;
+    compMode |= Kd != T(0) ? DIGITAL_CONTROL::D_BIT : 0;
     compensationMode = compMode;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////////////////////////
-void PID_Controller::configureGains(double _kp, double _ki, double _kd)
+template <typename T>
+void PID_ControllerT<T>::configureGains(T _kp, T _ki, T _kd)
 {
     Kp = _kp;
     Ki = _ki;
@@ -59,7 +65,8 @@ void PID_Controller::configureGains(double _kp, double _ki, double _kd)
 //////////////////////////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////////////////////////
-void PID_Controller::configureIntegratorSaturation(double ulim, double llim)
+template <typename T>
+void PID_ControllerT<T>::configureIntegratorSaturation(T ulim, T llim)
 {
     integrator_limits.llim = llim;
     integrator_limits.ulim = ulim;
@@ -69,36 +76,74 @@ void PID_Controller::configureIntegratorSaturation(double ulim, double llim)
 //////////////////////////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////////////////////////
-void PID_Controller::configureOutputSaturation(double ulim, double llim)
+template <typename T>
+void PID_ControllerT<T>::configureOutputSaturation(T ulim, T llim)
 {
     output_limits.llim = llim;
     output_limits.ulim = ulim;
     limit_output = true;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Runs the D term through a PID_DERIVATIVE_FILTER_ORDER IIR filter instead of
+/// differencing. The filter is the differentiator, so its coefficients must include the
+/// 1/dt scaling for the loop's sample rate (e.g. DIGITAL_CONTROL::bldiff_30_b/_a).
+//////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+void PID_ControllerT<T>::configureDerivativeFilter(const double *b, const double *a)
+{
+    // Invalid poles leave the raw difference in place
+    filter_derivative = diffFilter.configure(b, a);
+    diffFilter.reset();
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////////////////////////
-void PID_Controller::reset()
+template <typename T>
+void PID_ControllerT<T>::disableDerivativeFilter()
+{
+    filter_derivative = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief While the output is saturated, feeds Kb * (saturated - unsaturated output) back
+/// into the integrator so it unwinds instead of growing. Kb around 1/Ti (or Ki/Kp) is a
+/// reasonable start; 0 turns it off. Only does anything with output saturation configured.
+//////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+void PID_ControllerT<T>::configureAntiWindup(T _kb)
+{
+    Kb = _kb;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+void PID_ControllerT<T>::reset()
 {
     firstTime = true;
-    e_prev = 0;
-    integratorState = 0.0;
+    e_prev = T(0);
+    outputSaturatedFlag = false;
+    diffFilter.reset();
     resetIntegrator();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////////////////////////
-void PID_Controller::resetIntegrator()
+template <typename T>
+void PID_ControllerT<T>::resetIntegrator()
 {
-    integratorState = 0.0;
+    integratorState = T(0);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////////////////////////
-bool PID_Controller::integratorIsSaturated()
+template <typename T>
+bool PID_ControllerT<T>::integratorIsSaturated()
 {
     bool satFlag = (integratorState == integrator_limits.ulim) || (integratorState == integrator_limits.llim);
     return satFlag;
@@ -107,7 +152,8 @@ bool PID_Controller::integratorIsSaturated()
 //////////////////////////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////////////////////////
-bool PID_Controller::outputIsSaturated()
+template <typename T>
+bool PID_ControllerT<T>::outputIsSaturated()
 {
     return outputSaturatedFlag;
 }
@@ -115,14 +161,13 @@ bool PID_Controller::outputIsSaturated()
 //////////////////////////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////////////////////////
-void PID_Controller::update(double e, double dt, double *uC)
+template <typename T>
+void PID_ControllerT<T>::update(T e, T dt, T *uC)
 {
-    double prop_term{0};
-    double int_term{0};
-    double diff_term{0};
-    // double output_pre_sat{0};
-    // double output_post_sat{0};
-    double output{0};
+    T prop_term(0);
+    T int_term(0);
+    T diff_term(0);
+    T output(0);
 
     if (compensationMode & DIGITAL_CONTROL::P_BIT)
     {
@@ -134,7 +179,7 @@ void PID_Controller::update(double e, double dt, double *uC)
     {
         integratorState += e * Ki * dt;
         if (limit_integrator)
-            int_term = saturate(integratorState, integrator_limits.llim, integrator_limits.ulim);
+            int_term = DIGITAL_CONTROL::clampToLimits(integratorState, integrator_limits.llim, integrator_limits.ulim);
         else
             int_term = integratorState;
         output += int_term;
@@ -142,8 +187,12 @@ void PID_Controller::update(double e, double dt, double *uC)
 
     if (compensationMode & DIGITAL_CONTROL::D_BIT)
     {
-        double diff = 0;
-        if (!firstTime)
+        T diff(0);
+        if (filter_derivative)
+        {
+            diff = diffFilter.update(e);
+        }
+        else if (!firstTime)
         {
             diff = (e - e_prev)/dt;
         }
@@ -153,5 +202,18 @@ void PID_Controller::update(double e, double dt, double *uC)
         output += diff_term;
     }
 
-    *uC = output;
-}
\ No newline at end of file
+    T output_sat = output;
+    if (limit_output)
+    {
+        output_sat = DIGITAL_CONTROL::clampToLimits(output, output_limits.llim, output_limits.ulim);
+        outputSaturatedFlag = (output_sat != output);
+        if (outputSaturatedFlag && (compensationMode & DIGITAL_CONTROL::I_BIT))
+            integratorState += Kb * (output_sat - output) * dt;
+    }
+
+    *uC = output_sat;
+}
+
+template class PID_ControllerT<double>;
+template class PID_ControllerT<float>;
+template class PID_ControllerT<DIGITAL_CONTROL::Q16_16>;
@@ -0,0 +1,46 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+///
+
+#include "../include/ProfileZones.h"
+
+#include <cstring>
+
+LFAST::ProfileZone LFAST::ProfileZones::zones[MAX_PROFILE_ZONES];
+size_t LFAST::ProfileZones::numZones = 0;
+
+/// @brief Finds the zone with this name, adding it if it's new
+/// @return nullptr if the table is full (that zone just isn't timed)
+LFAST::ProfileZone *LFAST::ProfileZones::zone(const char *name)
+{
+    for (size_t ii = 0; ii < numZones; ii++)
+    {
+        if (std::strcmp(zones[ii].name, name) == 0)
+            return &zones[ii];
+    }
+    if (numZones == MAX_PROFILE_ZONES)
+        return nullptr;
+    ProfileZone *newZone = &zones[numZones++];
+    newZone->name = name;
+    newZone->reset();
+    return newZone;
+}
+
+void LFAST::ProfileZones::resetAll()
+{
+    for (size_t ii = 0; ii < numZones; ii++)
+        zones[ii].reset();
+}
@@ -0,0 +1,189 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file SerialCommsService.cc
+///
+
+#include "../include/SerialCommsService.h"
+
+#include <Arduino.h>
+#include <cstring>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////// PUBLIC FUNCTIONS ///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Starts a hardware UART and adds it as a link
+/// @param port Serial port (e.g. MODBUS_SERIAL)
+/// @param baud Baud rate
+/// @param txEnablePin RS-485 driver enable pin (e.g. MODBUS_RTS_PIN), or -1 for full duplex links
+/// @return service status
+bool LFAST::SerialCommsService::initializeSerialIface(HardwareSerial &port, uint32_t baud, int txEnablePin)
+{
+    port.begin(baud);
+    if (txEnablePin >= 0)
+        port.transmitterEnable(txEnablePin);
+    return addSerialLink(port);
+}
+
+/// @brief Adds any Stream (UART, USB serial, ...) as a COBS framed connection
+/// @return false if there's no room for another link
+bool LFAST::SerialCommsService::addSerialLink(Stream &stream)
+{
+    if (serialLinks.size() >= MAX_SERIAL_LINKS)
+    {
+#if defined(TERMINAL_ENABLED)
+        if (cli != nullptr)
+            cli->printDebugMessage("No room for another serial link.", LFAST::WARNING_MESSAGE);
+#endif
+        return false;
+    }
+    serialLinks.emplace_back(stream);
+    // The active connection pointer may not survive the vector growing
+    this->activeConnection = nullptr;
+    setupClientMessageBuffers(&serialLinks.back().client, true);
+    commsServiceStatus = true;
+    return commsServiceStatus;
+}
+
+/// @brief Services any stream clients, then pulls everything buffered on each serial link
+///
+/// Reads happen in SERIAL_RX_CHUNK_SIZE blocks and never wait for a frame to
+/// finish; partial frames stay in the link's decoder until the next call.
+///
+/// @return true if a new message was queued
+bool LFAST::SerialCommsService::checkForNewClientData()
+{
+    bool newMsgFlag = CommsService::checkForNewClientData();
+
+    for (auto &link : serialLinks)
+    {
+        int bytesAvail = link.client.available();
+        if (bytesAvail <= 0)
+            continue;
+
+        ClientConnection *conn = getLinkConnection(link);
+        if (conn == nullptr)
+            continue;
+
+        uint8_t chunk[SERIAL_RX_CHUNK_SIZE];
+        while (bytesAvail > 0)
+        {
+            size_t toRead = std::min((size_t)bytesAvail, sizeof(chunk));
+            int bytesRead = link.client.read(chunk, toRead);
+            if (bytesRead <= 0)
+                break;
+            bytesAvail -= bytesRead;
+
+            link.decoder.feed(chunk, bytesRead, [&](const uint8_t *frame, size_t len)
+                              {
+                auto newMsg = CommsMessageBase::newForLength(len);
+                recordRx(conn, len, newMsg != nullptr);
+                if (newMsg == nullptr)
+                    return;
+                captureFrame(conn, frame, len);
+                std::memcpy(newMsg->jsonInputBuffer, frame, len);
+                newMsg->setInputLength(len);
+                conn->binaryPeer = newMsg->isBinary();
+#if defined(TERMINAL_ENABLED)
+                if (!newMsg->isBinary() && cli != nullptr)
+                    cli->updatePersistentField(infoFields[RAW_MESSAGE_RECEIVED_ROW], newMsg->jsonInputBuffer);
+#endif
+                conn->rxMessageQueue.push_back(newMsg);
+                newMsgFlag = true; });
+        }
+        // Frames the decoder threw away (malformed or longer than its buffer)
+        for (; link.decodeErrorsSeen < link.decoder.errors(); link.decodeErrorsSeen++)
+            recordRx(conn, 0, false);
+    }
+    return newMsgFlag;
+}
+
+/// @brief Sends a message as a single COBS frame
+///
+/// Replies go back in the format the link last used. ALL_CONNECTED sends the
+/// message out every serial link. Anything else is handed off to CommsService.
+///
+/// @param msg Message to send
+/// @param sendOpt ACTIVE_CONNECTION or ALL_CONNECTED
+void LFAST::SerialCommsService::sendMessage(CommsMessageBase &msg, uint8_t sendOpt)
+{
+    if (sendOpt == ALL_CONNECTED)
+    {
+        for (auto &link : serialLinks)
+        {
+            ClientConnection *conn = getLinkConnection(link);
+            if (conn != nullptr)
+                sendFrame(msg, *conn);
+        }
+        return;
+    }
+
+    if (activeConnection == nullptr || !activeConnection->framedLink)
+    {
+        CommsService::sendMessage(msg, sendOpt);
+        return;
+    }
+    stampCorrelationId(msg, *activeConnection);
+    sendFrame(msg, *activeConnection);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////// LOCAL/PRIVATE FUNCTIONS ////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LFAST::ClientConnection *LFAST::SerialCommsService::getLinkConnection(SerialLink &link)
+{
+    for (auto &conn : this->connections)
+    {
+        if (conn.client == &link.client)
+            return &conn;
+    }
+    return nullptr;
+}
+
+void LFAST::SerialCommsService::sendFrame(CommsMessageBase &msg, ClientConnection &conn)
+{
+    static char payload[LARGE_MSG_BUFF_SIZE];
+    static uint8_t frame[LFAST::cobsMaxEncodedLength(LARGE_MSG_BUFF_SIZE) + 1];
+
+    JsonDocument &doc = msg.getJsonDoc();
+    size_t payloadLen;
+    if (conn.binaryPeer)
+        payloadLen = measureMsgPack(doc) <= sizeof(payload) ? serializeMsgPack(doc, payload, sizeof(payload)) : 0;
+    else
+        payloadLen = measureJson(doc) < sizeof(payload) ? serializeJson(doc, payload, sizeof(payload)) : 0;
+
+    if (payloadLen == 0)
+    {
+        recordTx(&conn, msg, 0);
+#if defined(TERMINAL_ENABLED)
+        if (cli != nullptr)
+            cli->printDebugMessage("Message too large for a serial frame.", LFAST::ERROR_MESSAGE);
+#endif
+        return;
+    }
+
+#if defined(TERMINAL_ENABLED)
+    if (cli != nullptr && !conn.binaryPeer)
+        cli->updatePersistentField(infoFields[MESSAGE_SENT_ROW], payload);
+#endif
+
+    size_t frameLen = LFAST::cobsEncode((const uint8_t *)payload, payloadLen, frame);
+    frame[frameLen++] = 0;
+    conn.client->write(frame, frameLen);
+    recordTx(&conn, msg, payloadLen);
+}
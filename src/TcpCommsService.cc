@@ -68,14 +68,24 @@ LFAST::TcpCommsService::TcpCommsService(byte*ipBytes=(byte*)&defaultIpAddr)
 
 bool LFAST::TcpCommsService::initializeEnetIface(uint16_t _port)
 {
-    bool initResult = true;
     tcpServer = new EthernetServer(_port);
 
+    if (configureEnetHardware(ip))
+        commsServiceStatus = true;
+    return commsServiceStatus;
+}
+
+/// @brief Brings up the Ethernet PHY once, no matter how many services share it
+/// @param _ip Static IP address to assign
+/// @return false if the Ethernet hardware wasn't found
+bool LFAST::TcpCommsService::configureEnetHardware(IPAddress &_ip)
+{
+    bool initResult = true;
     if (!hardwareConfigurationDone)
     {
         getTeensyMacAddr(mac);
         // initialize the Ethernet device
-        Ethernet.begin(mac, ip);
+        Ethernet.begin(mac, _ip);
         // Ethernet.begin(mac, ip, myDns, gateway, subnet)
 
         // Check for Ethernet hardware present
@@ -89,9 +99,11 @@ bool LFAST::TcpCommsService::initializeEnetIface(uint16_t _port)
         }
         hardwareConfigurationDone = true;
     }
-    if (initResult)
-        commsServiceStatus = true;
-    return commsServiceStatus;
+    else if (Ethernet.hardwareStatus() == EthernetNoHardware)
+    {
+        initResult = false;
+    }
+    return initResult;
 }
 
 bool LFAST::TcpCommsService::checkForNewClients()
@@ -19,19 +19,20 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 
 #include <TerminalInterface.h>
 
+#if defined(ARDUINO)
 #include <Arduino.h>
+#endif
 
-#include <iostream>
 #include <string>
-#include <sstream>
-#include <iomanip>
 #include <stdio.h>
 
 #include <cinttypes>
 // #include <mathFuncs.h>
 #include <cstring>
+#include <cstdarg>
 #include <map>
 #include <utility>
+#include <malloc.h>
 
 #include "teensy41_device.h"
 
@@ -40,9 +41,13 @@ this program. If not, see <https://www.gnu.org/licenses/>.
 /// @param _serial 
 /// @param _baud 
 TerminalInterface::TerminalInterface(const std::string &_label, TEST_SERIAL_TYPE *_serial, uint32_t _baud = 230400)
-    : serial(_serial), ifLabel(_label)
+    : serial(_serial), lastServiceUs(0), loopTimingStarted(false), ifLabel(_label), screen(0, TERMINAL_WIDTH), serialOut(_serial), cursorAtPrompt(false),
+      anyFieldDirty(false), framePeriodMs(1000 / TERMINAL_FRAME_RATE_HZ), lastFrameMs(0),
+      txQueue(TERMINAL_TX_QUEUE_SIZE), drainBytesPerCall(TERMINAL_DRAIN_BYTES_PER_CALL)
 {
     serial->begin(_baud);
+    loopStats = {0, 0, UINT32_MAX, 0};
+    registerBuiltinCommands();
     initialize();
 };
 
@@ -50,7 +55,16 @@ TerminalInterface::TerminalInterface(const std::string &_label, TEST_SERIAL_TYPE
 void TerminalInterface::initialize()
 {
     clearConsole();
-    debugRowOffset = 0;
+    screen.markCleared();
+    // Drop any scroll region left over from before a reset
+    queueText("\033[r");
+    scrollRegionTop = 0;
+    debugLineHead = 0;
+    debugLineCount = 0;
+    // Input can arrive before the prompt is first drawn
+    std::memset(rxBuff, '\0', CLI_BUFF_LENGTH);
+    rxPtr = rxBuff;
+    currentInputCol = 4;
     debugMessageCount = 0;
     promptRow = LFAST::NUM_HEADER_ROWS + 1;
     printHeader();
@@ -74,6 +88,7 @@ void TerminalInterface::registerDevice(const std::string &devStr)
 /// @brief 
 void TerminalInterface::printHeader()
 {
+    txQueue.beginSequence();
     cursorToRow(LFAST::TOP_HEADER);
     white();
 
@@ -83,41 +98,79 @@ void TerminalInterface::printHeader()
     std::string HEADER_LABEL_ROW = HEADER_LABEL_ROW_SIDE + " " + HEADER_LABEL_STRING + " " + HEADER_LABEL_ROW_SIDE;
 
     cursorToRow(LFAST::TOP_HEADER);
-    serial->printf("%s", HEADER_BORDER_STRING.c_str());
+    queueText(HEADER_BORDER_STRING.c_str());
     cursorToRow(LFAST::MIDDLE_HEADER);
-    serial->printf("%s", HEADER_LABEL_ROW.c_str());
+    queueText(HEADER_LABEL_ROW.c_str());
     cursorToRow(LFAST::LOWER_HEADER);
-    serial->printf("%s", HEADER_BORDER_STRING.c_str());
-    delay(100);
+    queueText(HEADER_BORDER_STRING.c_str());
+    txQueue.endSequence();
+    cursorAtPrompt = false;
 }
 
 void TerminalInterface::resetPrompt()
 {
     messageRow = promptRow + 2;
+    txQueue.beginSequence();
     cursorToRowCol(messageRow, 0);
-    std::string DEBUG_BORDER_STR = std::string(TERMINAL_WIDTH, '-');
-    serial->printf("%s", DEBUG_BORDER_STR.c_str());
+    char debugBorder[TERMINAL_WIDTH + 1];
+    std::memset(debugBorder, '-', TERMINAL_WIDTH);
+    debugBorder[TERMINAL_WIDTH] = '\0';
+    queueText(debugBorder);
 
     showCursor();
     std::memset(rxBuff, '\0', CLI_BUFF_LENGTH);
     rxPtr = rxBuff;
     cursorToRow(promptRow);
-    serial->print(">> ");
+    queueText(">> ");
     clearToEndOfRow();
     currentInputCol = 4;
     cursorToCol(currentInputCol);
+    cursorAtPrompt = txQueue.endSequence();
     // BLINKING();
 }
 
+/// @brief Handles typed input and sends queued output
+///
+/// Changed persistent fields are repainted at most once per frame period, no
+/// matter how often devices update them. At most drainBytesPerCall bytes (and
+/// never more than the port can take without blocking) go out per call; the
+/// rest waits for the next one.
 void TerminalInterface::serviceCLI()
 {
 #if PRINT_SERVICE_COUNTER
     static uint64_t serviceCounter = 0;
     cursorToRowCol(SERVICE_COUNTER_ROW, 0);
-    serial->printf("[%o]", serviceCounter++);
+    queuef("[%o]", serviceCounter++);
 #endif
     // static int64_t cnt =0;
-    cursorToRowCol(promptRow, currentInputCol);
+    uint32_t nowUs = micros();
+    if (loopTimingStarted)
+    {
+        uint32_t periodUs = nowUs - lastServiceUs;
+        loopStats.count++;
+        loopStats.totalUs += periodUs;
+        if (periodUs < loopStats.minUs)
+            loopStats.minUs = periodUs;
+        if (periodUs > loopStats.maxUs)
+            loopStats.maxUs = periodUs;
+    }
+    lastServiceUs = nowUs;
+    loopTimingStarted = true;
+
+    uint32_t now = millis();
+    if (now - lastFrameMs >= framePeriodMs)
+    {
+        lastFrameMs = now;
+        repaintFields();
+    }
+    flushScreen();
+    if (!cursorAtPrompt)
+    {
+        // Typed characters are echoed here, so keep trying until the move is queued
+        txQueue.beginSequence();
+        cursorToRowCol(promptRow, currentInputCol);
+        cursorAtPrompt = txQueue.endSequence();
+    }
     if (serial->available() > 0)
     {
         // read the incoming byte:
@@ -130,7 +183,7 @@ void TerminalInterface::serviceCLI()
         else
         {
             // say what you got:
-            serial->printf("%c", c);
+            txQueue.write(&c, 1);
             // Put it in the buffer
             if (rxPtr < (rxBuff + CLI_BUFF_LENGTH - 1))
             {
@@ -139,22 +192,172 @@ void TerminalInterface::serviceCLI()
             }
         }
     }
+    txQueue.drain(serialOut, drainBytesPerCall);
 }
 
 
+/// @brief Runs the command typed at the prompt
+///
+/// The first word picks the command; the rest of the line is passed to its
+/// handler. Handlers print their output as debug messages.
 void TerminalInterface::handleCliCommand()
 {
+    txQueue.beginSequence();
     cursorToRow(promptRow + 1);
     clearToEndOfRow();
-    serial->printf("%s: Command Not Found.\r\n", rxBuff);
+    txQueue.endSequence();
+
+    char *cmd = rxBuff;
+    while (*cmd == ' ')
+        cmd++;
+    char *args = cmd;
+    while (*args != '\0' && *args != ' ')
+        args++;
+    if (*args != '\0')
+    {
+        *args++ = '\0';
+        while (*args == ' ')
+            args++;
+    }
+
+    if (*cmd != '\0')
+    {
+        CliCommand *found = nullptr;
+        for (auto &command : commands)
+        {
+            if (std::strcmp(command.name, cmd) == 0)
+            {
+                found = &command;
+                break;
+            }
+        }
+        if (found == nullptr)
+        {
+            queuef("%s: Command Not Found.\r\n", cmd);
+        }
+        else
+        {
+            queueText(cmd);
+            found->fn(this, args, found->context);
+        }
+    }
     resetPrompt();
 }
 
+/// @brief Adds a console command
+/// @param name What gets typed at the prompt (one word)
+/// @param help One line shown by "help"
+/// @param fn Handler
+/// @param context Passed back to the handler, e.g. the device's this pointer
+/// @return false if a command with that name already exists
+bool TerminalInterface::registerCommand(const char *name, const char *help, CliCommandHandler fn, void *context)
+{
+    for (auto &command : commands)
+    {
+        if (std::strcmp(command.name, name) == 0)
+            return false;
+    }
+    commands.push_back({name, help, fn, context});
+    return true;
+}
+
+/// @brief Adds something for the "reset" command to clear
+void TerminalInterface::registerResetHandler(CliResetHandler fn, void *context)
+{
+    resetHandlers.push_back(std::make_pair(fn, context));
+}
+
+/// @brief Clears loop timing, profiling zones and every registered device counter
+void TerminalInterface::resetCounters()
+{
+    loopStats = {0, 0, UINT32_MAX, 0};
+    loopTimingStarted = false;
+    LFAST::ProfileZones::resetAll();
+    for (auto &handler : resetHandlers)
+        handler.first(handler.second);
+}
+
+void TerminalInterface::registerBuiltinCommands()
+{
+    registerCommand("help", "List commands", helpCommand);
+    registerCommand("loop", "Main loop period and terminal output stats", loopCommand);
+    registerCommand("heap", "Heap usage", heapCommand);
+    registerCommand("zones", "Profiling zone timings", zonesCommand);
+    registerCommand("reset", "Clear loop, zone and device counters", resetCommand);
+}
+
+void TerminalInterface::helpCommand(TerminalInterface *cli, const char *, void *)
+{
+    for (auto &command : cli->commands)
+        cli->printfDebugMessage("%-10s %s", command.name, command.help);
+}
+
+void TerminalInterface::loopCommand(TerminalInterface *cli, const char *, void *)
+{
+    LoopStats &stats = cli->loopStats;
+    if (stats.count == 0)
+    {
+        cli->printDebugMessage("Loop: no samples yet");
+    }
+    else
+    {
+        cli->printfDebugMessage("Loop: %lu passes, period min/mean/max %lu/%lu/%lu us",
+                                (unsigned long)stats.count, (unsigned long)stats.minUs,
+                                (unsigned long)(stats.totalUs / stats.count), (unsigned long)stats.maxUs);
+    }
+    cli->printfDebugMessage("Terminal: %u bytes queued, %lu dropped",
+                            (unsigned int)cli->txQueue.pending(), (unsigned long)cli->txQueue.droppedBytes());
+}
+
+#if defined(ARDUINO_TEENSY41) || defined(ARDUINO_TEENSY40)
+extern "C" char *__brkval;
+extern unsigned long _heap_start;
+extern unsigned long _heap_end;
+#endif
+
+void TerminalInterface::heapCommand(TerminalInterface *cli, const char *, void *)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+#else
+    struct mallinfo info = mallinfo();
+#endif
+    cli->printfDebugMessage("Heap: %lu bytes in use, %lu free in arena",
+                            (unsigned long)info.uordblks, (unsigned long)info.fordblks);
+#if defined(ARDUINO_TEENSY41) || defined(ARDUINO_TEENSY40)
+    cli->printfDebugMessage("Heap: %lu bytes never claimed",
+                            (unsigned long)((char *)&_heap_end - __brkval));
+#endif
+}
+
+void TerminalInterface::zonesCommand(TerminalInterface *cli, const char *, void *)
+{
+    if (LFAST::ProfileZones::count() == 0)
+    {
+        cli->printDebugMessage("No profiling zones");
+        return;
+    }
+    for (size_t ii = 0; ii < LFAST::ProfileZones::count(); ii++)
+    {
+        LFAST::ProfileZone &zone = LFAST::ProfileZones::at(ii);
+        cli->printfDebugMessage("%-16s n=%lu mean=%lu min=%lu max=%lu us", zone.name,
+                                (unsigned long)zone.count, (unsigned long)zone.meanUs(),
+                                (unsigned long)(zone.count > 0 ? zone.minUs : 0), (unsigned long)zone.maxUs);
+    }
+}
+
+void TerminalInterface::resetCommand(TerminalInterface *cli, const char *, void *)
+{
+    cli->resetCounters();
+    cli->printDebugMessage("Counters reset");
+}
+
 /// @brief Add a persistent field label to the terminal
 /// @param device String identifying LFAST_Device adding the label
 /// @param label String label
 /// @param printRow The row the device wants to print the label on
-void TerminalInterface::addPersistentField(const std::string &device, const std::string &label, uint8_t printRow)
+/// @return Handle for updating the field without looking the device up again
+LFAST::PersistentFieldHandle TerminalInterface::addPersistentField(const std::string &device, const std::string &label, uint8_t printRow)
 {
     uint8_t deviceRowOffs = senderRowOffsetMap[device];
     uint8_t devicePrintRow = printRow + deviceRowOffs;
@@ -167,6 +370,8 @@ void TerminalInterface::addPersistentField(const std::string &device, const std:
         highestFieldRowNum = adjustedPrintRow;
         promptRow = highestFieldRowNum + 3;
         firstDebugRow = promptRow + 3;
+        screen.resize(highestFieldRowNum + 1);
+        fieldValues.resize(highestFieldRowNum + 1);
     }
 
     if (fieldStartCol < (label.size() + 1))
@@ -178,6 +383,10 @@ void TerminalInterface::addPersistentField(const std::string &device, const std:
     field->label = label;
     persistentFields.push_back(field);
     // resetPrompt();
+
+    LFAST::PersistentFieldHandle handle;
+    handle.row = adjustedPrintRow;
+    return handle;
 }
 
 
@@ -192,97 +401,246 @@ void TerminalInterface::printPersistentFieldLabels()
     // TEST_SERIAL.printf("Num fields:%d\r\n", persistentFields.size());
     for (auto field : persistentFields)
     {
-        cursorToRow(field->printRow);
-        clearToEndOfRow();
-        serial->printf("\033[0K\033[37m%s:\033[22G", field->label.c_str());
+        std::string labelStr = field->label + ":";
+        screen.put(field->printRow, 0, labelStr.c_str(), false);
     }
+    flushScreen();
     resetPrompt();
 }
 
-/// @brief Prints a new value for a persistent field
+/// @brief Sets a new value for a persistent field
+///
+/// Only stores the value and marks it changed; serviceCLI() formats and
+/// repaints changed fields at the frame rate, so calling this every loop
+/// costs no terminal output.
+///
+/// @param field Handle returned by addPersistentField()
+/// @param fieldVal value to print
+void TerminalInterface::updatePersistentField(LFAST::PersistentFieldHandle field, int fieldVal)
+{
+    PersistentFieldValue *value = fieldValue(field.row);
+    if (value == nullptr)
+        return;
+    value->type = PersistentFieldValue::INT_VALUE;
+    value->intVal = fieldVal;
+}
+
+/// @brief Sets a new value for a persistent field
+/// @param field Handle returned by addPersistentField()
+/// @param fieldVal value to print
+void TerminalInterface::updatePersistentField(LFAST::PersistentFieldHandle field, long fieldVal)
+{
+    PersistentFieldValue *value = fieldValue(field.row);
+    if (value == nullptr)
+        return;
+    value->type = PersistentFieldValue::LONG_VALUE;
+    value->longVal = fieldVal;
+}
+
+/// @brief Sets a new value for a persistent field
+/// @param field Handle returned by addPersistentField()
+/// @param fieldVal value to print
+/// @param fmt printf format for the value. Copied (up to PERSISTENT_FIELD_FMT_SIZE - 1
+/// characters), since the value is only formatted at the next repaint.
+void TerminalInterface::updatePersistentField(LFAST::PersistentFieldHandle field, double fieldVal, const char *fmt)
+{
+    PersistentFieldValue *value = fieldValue(field.row);
+    if (value == nullptr)
+        return;
+    value->type = PersistentFieldValue::DOUBLE_VALUE;
+    value->doubleVal = fieldVal;
+    std::strncpy(value->fmt, fmt, PERSISTENT_FIELD_FMT_SIZE - 1);
+    value->fmt[PERSISTENT_FIELD_FMT_SIZE - 1] = '\0';
+}
+
+/// @brief Sets a new value for a persistent field
+/// @param field Handle returned by addPersistentField()
+/// @param fieldValStr value to print
+void TerminalInterface::updatePersistentField(LFAST::PersistentFieldHandle field, const char *fieldValStr)
+{
+    PersistentFieldValue *value = fieldValue(field.row);
+    if (value == nullptr)
+        return;
+    // Copied, since the caller's buffer is usually gone by the next frame
+    value->type = PersistentFieldValue::TEXT_VALUE;
+    std::strncpy(value->text, fieldValStr, TERMINAL_WIDTH);
+    value->text[TERMINAL_WIDTH] = '\0';
+}
+
+/// @brief Sets a new value for a persistent field
+/// @param field Handle returned by addPersistentField()
+/// @param fieldValStr value to print
+void TerminalInterface::updatePersistentField(LFAST::PersistentFieldHandle field, const std::string &fieldValStr)
+{
+    updatePersistentField(field, fieldValStr.c_str());
+}
+
+/// @brief Sets a new value for a persistent field, found by device and row
+///
+/// Looks the device up on every call; keep the handle from addPersistentField()
+/// for fields that update often.
+///
 /// @param device String identifying LFAST_Device adding the label
 /// @param printRow The row the device wants to print the label on
 /// @param fieldVal value to print
 void TerminalInterface::updatePersistentField(const std::string &device, uint8_t printRow, int fieldVal)
 {
-    uint8_t deviceRowOffs = senderRowOffsetMap[device];
-    uint8_t devicePrintRow = printRow + deviceRowOffs;
-    uint16_t adjustedPrintRow = devicePrintRow + LFAST::NUM_HEADER_ROWS;
-    noInterrupts();
-    hideCursor();
-    cursorToRowCol(adjustedPrintRow, fieldStartCol + 4);
-    serial->print(fieldVal);
-    clearToEndOfRow();
-    interrupts();
+    LFAST::PersistentFieldHandle field;
+    field.row = fieldRow(device, printRow);
+    updatePersistentField(field, fieldVal);
 }
 
-/// @brief Prints a new value for a persistent field
+/// @brief Sets a new value for a persistent field, found by device and row
 /// @param device String identifying LFAST_Device adding the label
 /// @param printRow The row the device wants to print the label on
 /// @param fieldVal value to print
 void TerminalInterface::updatePersistentField(const std::string &device, uint8_t printRow, long fieldVal)
 {
-    uint8_t deviceRowOffs = senderRowOffsetMap[device];
-    uint8_t devicePrintRow = printRow + deviceRowOffs;
-    uint16_t adjustedPrintRow = devicePrintRow + LFAST::NUM_HEADER_ROWS;
-    noInterrupts();
-    hideCursor();
-    cursorToRowCol(adjustedPrintRow, fieldStartCol + 4);
-    serial->print(fieldVal);
-    clearToEndOfRow();
-    interrupts();
+    LFAST::PersistentFieldHandle field;
+    field.row = fieldRow(device, printRow);
+    updatePersistentField(field, fieldVal);
 }
 
-/// @brief Prints a new value for a persistent field
+/// @brief Sets a new value for a persistent field, found by device and row
 /// @param device String identifying LFAST_Device adding the label
 /// @param printRow The row the device wants to print the label on
 /// @param fieldVal value to print
+/// @param fmt printf format for the value
 void TerminalInterface::updatePersistentField(const std::string &device, uint8_t printRow, double fieldVal, const char *fmt)
 {
-    uint8_t deviceRowOffs = senderRowOffsetMap[device];
-    uint8_t devicePrintRow = printRow + deviceRowOffs;
-    uint16_t adjustedPrintRow = devicePrintRow + LFAST::NUM_HEADER_ROWS;
-    noInterrupts();
-    hideCursor();
-    cursorToRowCol(adjustedPrintRow, fieldStartCol + 4);
-    serial->printf(fmt, fieldVal);
-    clearToEndOfRow();
-    interrupts();
+    LFAST::PersistentFieldHandle field;
+    field.row = fieldRow(device, printRow);
+    updatePersistentField(field, fieldVal, fmt);
 }
 
+/// @brief Sets a new value for a persistent field, found by device and row
+/// @param device String identifying LFAST_Device adding the label
+/// @param printRow The row the device wants to print the label on
+/// @param fieldValStr value to print
+void TerminalInterface::updatePersistentField(const std::string &device, uint8_t printRow, const char *fieldValStr)
+{
+    LFAST::PersistentFieldHandle field;
+    field.row = fieldRow(device, printRow);
+    updatePersistentField(field, fieldValStr);
+}
 
-/// @brief Prints a new value for a persistent field
+/// @brief Sets a new value for a persistent field, found by device and row
 /// @param device String identifying LFAST_Device adding the label
 /// @param printRow The row the device wants to print the label on
-/// @param fieldVal value to print
+/// @param fieldValStr value to print
 void TerminalInterface::updatePersistentField(const std::string &device, uint8_t printRow, const std::string &fieldValStr)
+{
+    LFAST::PersistentFieldHandle field;
+    field.row = fieldRow(device, printRow);
+    updatePersistentField(field, fieldValStr.c_str());
+}
+
+/// @brief Terminal row of a device's field, the same way addPersistentField() placed it
+uint16_t TerminalInterface::fieldRow(const std::string &device, uint8_t printRow)
 {
     uint8_t deviceRowOffs = senderRowOffsetMap[device];
     uint8_t devicePrintRow = printRow + deviceRowOffs;
-    uint16_t adjustedPrintRow = devicePrintRow + LFAST::NUM_HEADER_ROWS;
-    uint16_t maxStrLen = (TERMINAL_WIDTH - fieldStartCol);
-    noInterrupts();
-    hideCursor();
-    cursorToRowCol(adjustedPrintRow, fieldStartCol + 4);
-    clearToEndOfRow();
-    if (fieldValStr.length() > maxStrLen)
-        serial->print(fieldValStr.substr(0, maxStrLen).c_str());
-    else
-        serial->print(fieldValStr.c_str());
+    return devicePrintRow + LFAST::NUM_HEADER_ROWS;
+}
 
-    clearToEndOfRow();
-    // showCursor();
-    interrupts();
+/// @brief Value slot for a row, marked dirty; nullptr if no field was added there
+TerminalInterface::PersistentFieldValue *TerminalInterface::fieldValue(uint16_t row)
+{
+    if (row >= fieldValues.size())
+        return nullptr;
+    PersistentFieldValue *value = &fieldValues[row];
+    value->dirty = true;
+    anyFieldDirty = true;
+    return value;
+}
+
+/// @brief Formats each changed field value into the screen buffer
+void TerminalInterface::repaintFields()
+{
+    if (!anyFieldDirty)
+        return;
+    anyFieldDirty = false;
+    char valBuff[TERMINAL_WIDTH + 1];
+    for (uint16_t row = 0; row < fieldValues.size(); row++)
+    {
+        PersistentFieldValue &value = fieldValues[row];
+        if (!value.dirty)
+            continue;
+        value.dirty = false;
+        switch (value.type)
+        {
+        case PersistentFieldValue::INT_VALUE:
+            snprintf(valBuff, sizeof(valBuff), "%d", value.intVal);
+            break;
+        case PersistentFieldValue::LONG_VALUE:
+            snprintf(valBuff, sizeof(valBuff), "%ld", value.longVal);
+            break;
+        case PersistentFieldValue::DOUBLE_VALUE:
+            snprintf(valBuff, sizeof(valBuff), value.fmt, value.doubleVal);
+            break;
+        case PersistentFieldValue::TEXT_VALUE:
+            setFieldText(row, value.text);
+            continue;
+        default:
+            continue;
+        }
+        setFieldText(row, valBuff);
+    }
+}
+
+void TerminalInterface::setFieldText(uint16_t row, const char *text)
+{
+    // Values start in the same column the direct-print version used (1 based fieldStartCol + 4)
+    screen.put(row, fieldStartCol + 3, text);
+}
+
+/// @brief Queues the persistent field changes
+///
+/// Waits (leaving the buffer dirty) until the queue could hold a full repaint,
+/// so a partly-sent frame never leaves the screen out of step with the buffer.
+void TerminalInterface::flushScreen()
+{
+    if (!screen.dirty())
+        return;
+    size_t worstCase = (size_t)screen.rows() * (screen.cols() + 16) + 16;
+    if (txQueue.space() < worstCase)
+        return;
+    if (screen.flush(txQueue, WHITE "\033[?25l") > 0)
+        cursorAtPrompt = false;
+}
+
+void TerminalInterface::queueText(const char *text)
+{
+    txQueue.write(text, std::strlen(text));
+}
+
+void TerminalInterface::queuef(const char *fmt, ...)
+{
+    char buff[CLI_BUFF_LENGTH + 32];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(buff, sizeof(buff), fmt, args);
+    va_end(args);
+    if (len < 0)
+        return;
+    if ((size_t)len >= sizeof(buff))
+        len = sizeof(buff) - 1;
+    txQueue.write(buff, len);
 }
 
 /// @brief Prints a debug message to the terminal
+///
+/// The debug rows are an ANSI scroll region, so once they're full a new
+/// message scrolls the region up a line instead of reprinting every row.
+/// The line is formatted straight into its slot in the history ring; nothing
+/// is allocated.
+///
 /// @param msg Message string
 /// @param level 0-4 to determine severity (coloring)
-void TerminalInterface::printDebugMessage(const std::string &msg, uint8_t level)
+void TerminalInterface::printDebugMessage(const char *msg, uint8_t level)
 {
-
     debugMessageCount++;
-    std::string colorStr;
+    const char *colorStr;
     switch (level)
     {
     case LFAST::DEBUG_MESSAGE:
@@ -299,33 +657,81 @@ void TerminalInterface::printDebugMessage(const std::string &msg, uint8_t level)
         colorStr = WHITE;
         break;
     }
-    std::stringstream ss;
-    ss << std::setiosflags(std::ios::left) << std::setw(12);
-    ss << WHITE << debugMessageCount << "[" << millis() << "]: " << colorStr << msg;
-    std::string msgPrintSr = ss.str();
-
-    // serial->printf("[%d]", debugMessageCount);
-    noInterrupts();
-    if (debugMessages.size() < LFAST::MAX_DEBUG_ROWS)
+
+    cursorAtPrompt = false;
+
+    bool wasFull = (debugLineCount == LFAST::MAX_DEBUG_ROWS);
+    char *line;
+    if (wasFull)
     {
-        cursorToRowCol((firstDebugRow + debugRowOffset++), 0);
-        clearToEndOfRow();
-        debugMessages.push_back(msgPrintSr);
-        serial->print(msgPrintSr.c_str());
+        line = debugLines[debugLineHead];
+        debugLineHead = (debugLineHead + 1) % LFAST::MAX_DEBUG_ROWS;
     }
     else
     {
-        debugMessages.pop_front();
-        debugMessages.push_back(msgPrintSr);
-        for (uint16_t ii = 0; ii < LFAST::MAX_DEBUG_ROWS; ii++)
-        {
-            cursorToRowCol((firstDebugRow + ii), 0);
-            clearToEndOfRow();
-            serial->print(debugMessages.at(ii).c_str());
-            // serial->printf(" [fdr:%d][dro:%d][ii:%d]", firstDebugRow, debugRowOffset, ii);
-        }
+        line = debugLines[(debugLineHead + debugLineCount++) % LFAST::MAX_DEBUG_ROWS];
+    }
+    LFAST::formatDebugLine(line, DEBUG_LINE_CHARS, debugMessageCount, (unsigned long)millis(), colorStr, msg);
+
+    if (scrollRegionTop != firstDebugRow)
+    {
+        // The field area grew (or this is the first message), so the region moved
+        setDebugScrollRegion();
+        repaintDebugLines();
+    }
+    else if (wasFull)
+    {
+        txQueue.beginSequence();
+        cursorToRowCol(firstDebugRow + LFAST::MAX_DEBUG_ROWS - 1, 0);
+        queueText("\n\r");
+        writeDebugLine(line);
+        txQueue.endSequence();
+    }
+    else
+    {
+        txQueue.beginSequence();
+        cursorToRowCol(firstDebugRow + debugLineCount - 1, 0);
+        clearToEndOfRow();
+        writeDebugLine(line);
+        txQueue.endSequence();
+    }
+}
+
+/// @brief Prints a debug message to the terminal
+/// @param msg Message string
+/// @param level 0-4 to determine severity (coloring)
+void TerminalInterface::printDebugMessage(const std::string &msg, uint8_t level)
+{
+    printDebugMessage(msg.c_str(), level);
+}
+
+/// @brief Limits scrolling to the debug rows (DECSTBM)
+void TerminalInterface::setDebugScrollRegion()
+{
+    queuef("\033[%u;%ur", firstDebugRow + 1, firstDebugRow + LFAST::MAX_DEBUG_ROWS);
+    scrollRegionTop = firstDebugRow;
+}
+
+void TerminalInterface::repaintDebugLines()
+{
+    for (uint16_t ii = 0; ii < debugLineCount; ii++)
+    {
+        txQueue.beginSequence();
+        cursorToRowCol(firstDebugRow + ii, 0);
+        clearToEndOfRow();
+        writeDebugLine(debugLines[(debugLineHead + ii) % LFAST::MAX_DEBUG_ROWS]);
+        txQueue.endSequence();
     }
-    interrupts();
+}
+
+/// @brief Prints a stored line with autowrap off, so a long one can't scroll the region
+///
+/// Callers wrap this and the cursor move before it in a txQueue sequence.
+void TerminalInterface::writeDebugLine(const char *line)
+{
+    queueText("\033[?7l");
+    queueText(line);
+    queueText("\033[?7h");
 }
 
 int fs_sexa(char *out, double a, int w, int fracbase)
@@ -0,0 +1,111 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file TerminalOutputQueue.cc
+///
+
+#include "../include/TerminalOutputQueue.h"
+
+#include <cstring>
+
+LFAST::TerminalOutputQueue::TerminalOutputQueue(size_t _capacity)
+    : ring(_capacity), head(0), tail(0), count(0), dropped(0),
+      inSequence(false), sequenceDropped(false), sequenceHead(0), sequenceCount(0)
+{
+}
+
+/// @brief Copies data into the ring
+///
+/// Inside a sequence, a write that doesn't fit also takes back everything
+/// queued since beginSequence(), and the rest of the sequence is dropped.
+///
+/// @return len if it was queued, 0 if there wasn't room for all of it
+size_t LFAST::TerminalOutputQueue::write(const char *data, size_t len)
+{
+    if (inSequence && sequenceDropped)
+    {
+        dropped += len;
+        return 0;
+    }
+    if (len > space())
+    {
+        dropped += len;
+        if (inSequence)
+        {
+            dropped += count - sequenceCount;
+            head = sequenceHead;
+            count = sequenceCount;
+            sequenceDropped = true;
+        }
+        return 0;
+    }
+    size_t firstPart = ring.size() - head;
+    if (firstPart > len)
+        firstPart = len;
+    std::memcpy(&ring[head], data, firstPart);
+    std::memcpy(&ring[0], data + firstPart, len - firstPart);
+    head = (head + len) % ring.size();
+    count += len;
+    return len;
+}
+
+/// @brief Passes queued bytes on to sink
+/// @param maxBytes Most bytes to hand over in this call
+/// @return Number of bytes the sink accepted
+size_t LFAST::TerminalOutputQueue::drain(TerminalOutput &sink, size_t maxBytes)
+{
+    size_t sent = 0;
+    while (count > 0 && sent < maxBytes)
+    {
+        // Contiguous stretch from the tail, up to the end of the ring
+        size_t chunk = ring.size() - tail;
+        if (chunk > count)
+            chunk = count;
+        if (chunk > maxBytes - sent)
+            chunk = maxBytes - sent;
+
+        size_t accepted = sink.write(&ring[tail], chunk);
+        tail = (tail + accepted) % ring.size();
+        count -= accepted;
+        sent += accepted;
+        if (accepted < chunk)
+            break;
+    }
+    return sent;
+}
+
+void LFAST::TerminalOutputQueue::clear()
+{
+    head = tail = count = 0;
+    inSequence = false;
+}
+
+/// @brief Starts a group of writes that is queued or dropped as a unit
+///
+/// Nothing may be drained until endSequence().
+void LFAST::TerminalOutputQueue::beginSequence()
+{
+    inSequence = true;
+    sequenceDropped = false;
+    sequenceHead = head;
+    sequenceCount = count;
+}
+
+/// @return false if the sequence was dropped
+bool LFAST::TerminalOutputQueue::endSequence()
+{
+    inSequence = false;
+    return !sequenceDropped;
+}
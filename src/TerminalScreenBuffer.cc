@@ -0,0 +1,154 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file TerminalScreenBuffer.cc
+///
+
+#include "../include/TerminalScreenBuffer.h"
+
+#include <cstdio>
+#include <cstring>
+
+// Unchanged cells shorter than this between two changes are resent rather
+// than skipped, since a cursor move costs about this many bytes
+#define MIN_SKIP_RUN 6
+
+LFAST::TerminalScreenBuffer::TerminalScreenBuffer(uint16_t _rows, uint16_t _cols)
+    : numRows(0), numCols(_cols), anyRowDirty(false)
+{
+    resize(_rows);
+}
+
+/// @brief Grows (or shrinks) the buffered area; new rows start out blank
+void LFAST::TerminalScreenBuffer::resize(uint16_t newRows)
+{
+    numRows = newRows;
+    front.resize((size_t)numRows * numCols, ' ');
+    back.resize((size_t)numRows * numCols, ' ');
+    rowDirty.resize(numRows, 0);
+}
+
+/// @brief Writes text into the back buffer; nothing is sent until flush()
+/// @param row Terminal row (0 based)
+/// @param col Terminal column (0 based)
+/// @param text Null terminated; anything past the last column is cut off
+/// @param clearToEol Blank the rest of the row after the text
+void LFAST::TerminalScreenBuffer::put(uint16_t row, uint16_t col, const char *text, bool clearToEol)
+{
+    if (row >= numRows || col >= numCols)
+        return;
+    char *cell = &back[index(row, col)];
+    uint16_t remaining = numCols - col;
+    while (remaining > 0 && *text != '\0')
+    {
+        // Control characters would desync the front buffer from the screen
+        *cell++ = (*text >= ' ') ? *text : ' ';
+        text++;
+        remaining--;
+    }
+    if (clearToEol)
+        std::memset(cell, ' ', remaining);
+    rowDirty[row] = 1;
+    anyRowDirty = true;
+}
+
+/// @brief Sends whatever changed since the last flush
+/// @param prefix Sent ahead of the first change, if there are any (e.g. a color)
+/// @return Number of bytes written to out
+size_t LFAST::TerminalScreenBuffer::flush(TerminalOutput &out, const char *prefix)
+{
+    if (!anyRowDirty)
+        return 0;
+
+    size_t bytesOut = 0;
+    // Where the terminal's cursor is known to be; unknown at the start of a flush
+    int curRow = -1, curCol = -1;
+    for (uint16_t row = 0; row < numRows; row++)
+    {
+        if (!rowDirty[row])
+            continue;
+        rowDirty[row] = 0;
+
+        const char *b = &back[index(row, 0)];
+        char *f = &front[index(row, 0)];
+
+        // Past this column the back row is blank, so an erase-to-end can replace the run
+        uint16_t blankFrom = numCols;
+        while (blankFrom > 0 && b[blankFrom - 1] == ' ')
+            blankFrom--;
+
+        uint16_t col = 0;
+        while (col < numCols)
+        {
+            if (b[col] == f[col])
+            {
+                col++;
+                continue;
+            }
+
+            if (bytesOut == 0 && prefix != nullptr)
+                bytesOut += out.write(prefix, std::strlen(prefix));
+            if (curRow != row || curCol != col)
+                bytesOut += emitCursorMove(out, row, col);
+            if (col >= blankFrom)
+            {
+                bytesOut += out.write("\033[0K", 4);
+                std::memset(f + col, ' ', numCols - col);
+                curRow = row;
+                curCol = col;
+                break;
+            }
+
+            // Extend the run until the next long enough stretch of unchanged cells
+            uint16_t runEnd = col + 1;
+            uint16_t same = 0;
+            for (uint16_t ii = runEnd; ii < blankFrom && same < MIN_SKIP_RUN; ii++)
+            {
+                if (b[ii] == f[ii])
+                {
+                    same++;
+                }
+                else
+                {
+                    same = 0;
+                    runEnd = ii + 1;
+                }
+            }
+            bytesOut += out.write(b + col, runEnd - col);
+            std::memcpy(f + col, b + col, runEnd - col);
+            col = runEnd;
+            curRow = row;
+            curCol = col;
+        }
+    }
+    anyRowDirty = false;
+    return bytesOut;
+}
+
+/// @brief Call after the terminal has been cleared, so the front buffer matches it again
+void LFAST::TerminalScreenBuffer::markCleared()
+{
+    std::memset(front.data(), ' ', front.size());
+    for (uint16_t row = 0; row < numRows; row++)
+        rowDirty[row] = 1;
+    anyRowDirty = true;
+}
+
+size_t LFAST::TerminalScreenBuffer::emitCursorMove(TerminalOutput &out, uint16_t row, uint16_t col)
+{
+    char seq[16];
+    int len = snprintf(seq, sizeof(seq), "\033[%u;%uH", row + 1, col + 1);
+    return out.write(seq, len);
+}
@@ -0,0 +1,414 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file UdpCommsService.cc
+///
+
+#include "../include/UdpCommsService.h"
+
+#include <Arduino.h>
+
+#ifdef TEENSYDUINO
+#include <NativeEthernet.h>
+#include <NativeEthernetUdp.h>
+#else
+#include <SPI.h>
+#include <Ethernet.h>
+#include <EthernetUdp.h>
+#endif
+
+#include <vector>
+#include <iterator>
+
+byte defaultUdpIpAddr[4] = {0, 0, 0, 0};
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////// PUBLIC FUNCTIONS ///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+LFAST::UdpCommsService::UdpCommsService(byte *ipBytes = (byte *)&defaultUdpIpAddr)
+{
+    ip = IPAddress(ipBytes[0], ipBytes[1], ipBytes[2], ipBytes[3]);
+}
+
+/// @brief Brings up the Ethernet hardware (if TCP hasn't already) and opens the UDP socket
+/// @param _port Local port to listen on
+/// @return service status
+bool LFAST::UdpCommsService::initializeUdpIface(uint16_t _port)
+{
+    if (TcpCommsService::configureEnetHardware(ip))
+    {
+        commsServiceStatus = (udp.begin(_port) == 1);
+    }
+    return commsServiceStatus;
+}
+
+/// @brief Services any stream clients, then drains every pending datagram into its peer's queue
+/// @return true if a new message was queued
+bool LFAST::UdpCommsService::checkForNewClientData()
+{
+    bool newMsgFlag = CommsService::checkForNewClientData();
+
+    int packetSize;
+    while ((packetSize = udp.parsePacket()) > 0)
+    {
+        // Picks the smallest message class that still leaves room for the null terminator
+        auto newMsg = CommsMessageBase::newForLength(packetSize);
+        if (newMsg == nullptr)
+        {
+            recordRx(nullptr, packetSize, false);
+#if defined(TERMINAL_ENABLED)
+            if (cli != nullptr)
+                cli->printfDebugMessage("Dropped oversized datagram (%d bytes)", packetSize);
+#endif
+            continue;
+        }
+
+        ClientConnection *peer = getDatagramPeer(udp.remoteIP(), udp.remotePort());
+        if (peer == nullptr)
+        {
+            recordRx(nullptr, packetSize, false);
+            delete newMsg;
+            continue;
+        }
+
+        int bytesRead = udp.read((unsigned char *)newMsg->jsonInputBuffer, packetSize);
+        if (bytesRead <= 0)
+        {
+            delete newMsg;
+            continue;
+        }
+        captureFrame(peer, newMsg->jsonInputBuffer, bytesRead);
+        newMsg->setInputLength(bytesRead);
+        peer->binaryPeer = newMsg->isBinary();
+#if defined(TERMINAL_ENABLED)
+        if (!peer->binaryPeer && cli != nullptr)
+        {
+            cli->updatePersistentField(infoFields[RAW_MESSAGE_RECEIVED_ROW], newMsg->jsonInputBuffer);
+        }
+#endif
+
+        if (!acceptSequencedMessage(*peer, newMsg))
+        {
+            recordRx(peer, bytesRead, false);
+            delete newMsg;
+            continue;
+        }
+        recordRx(peer, bytesRead, true);
+        peer->rxMessageQueue.push_back(newMsg);
+        newMsgFlag = true;
+    }
+    return newMsgFlag;
+}
+
+/// @brief Sends a message as a single datagram
+///
+/// Replies to datagram peers go back in the format the peer last used, stamped
+/// with that peer's outgoing sequence number. ALL_CONNECTED sends the message
+/// to every known datagram peer (e.g. for telemetry). Stream clients are
+/// handed off to CommsService.
+///
+/// @param msg Message to send
+/// @param sendOpt ACTIVE_CONNECTION or ALL_CONNECTED
+void LFAST::UdpCommsService::sendMessage(CommsMessageBase &msg, uint8_t sendOpt)
+{
+    if (sendOpt == ALL_CONNECTED)
+    {
+        for (auto &conn : this->connections)
+        {
+            if (conn.isDatagramPeer())
+                sendDatagram(msg, conn);
+        }
+        return;
+    }
+
+    if (activeConnection == nullptr || !activeConnection->isDatagramPeer())
+    {
+        CommsService::sendMessage(msg, sendOpt);
+        return;
+    }
+    stampCorrelationId(msg, *activeConnection);
+    sendDatagram(msg, *activeConnection);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////// LOCAL/PRIVATE FUNCTIONS ////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Finds the connection entry for a remote endpoint, adding one if there's room
+///
+/// When the table is full, the peer heard from least recently is replaced if
+/// it has been idle for UDP_PEER_IDLE_TIMEOUT_MS. Active peers are never
+/// evicted, so a burst from new endpoints can't take over a live setpoint stream.
+///
+/// @return nullptr if the peer table is full of active peers
+LFAST::ClientConnection *LFAST::UdpCommsService::getDatagramPeer(const IPAddress &remoteIp, uint16_t remotePort)
+{
+    uint32_t now = millis();
+    unsigned int numPeers = 0;
+    ClientConnection *idlest = nullptr;
+    for (auto &conn : this->connections)
+    {
+        if (!conn.isDatagramPeer())
+            continue;
+        if (conn.remoteIp == remoteIp && conn.remotePort == remotePort)
+        {
+            // After a long silence the sender may have restarted its sequence numbers
+            if (now - conn.lastRxMs > UDP_PEER_IDLE_TIMEOUT_MS)
+                conn.rxSeqValid = false;
+            conn.lastRxMs = now;
+            return &conn;
+        }
+        if (idlest == nullptr || (now - conn.lastRxMs) > (now - idlest->lastRxMs))
+            idlest = &conn;
+        numPeers++;
+    }
+
+    if (numPeers >= MAX_UDP_PEERS)
+    {
+        if (idlest == nullptr || now - idlest->lastRxMs <= UDP_PEER_IDLE_TIMEOUT_MS)
+        {
+#if defined(TERMINAL_ENABLED)
+            if (cli != nullptr)
+                cli->printDebugMessage("Datagram peer table full, dropping.", LFAST::WARNING_MESSAGE);
+#endif
+            return nullptr;
+        }
+
+        // Reuse the entry in place, so pointers to the other connections stay valid
+        for (auto msg : idlest->rxMessageQueue)
+            delete msg;
+        idlest->rxMessageQueue.clear();
+        // A new peer, so a new id in captures
+        idlest->id = ClientConnection::nextId();
+        idlest->remoteIp = remoteIp;
+        idlest->remotePort = remotePort;
+        idlest->binaryPeer = false;
+        idlest->rxSeqValid = false;
+        idlest->rxSeqNo = 0;
+        idlest->txSeqNo = 0;
+        idlest->hasCorrelationId = false;
+        idlest->stats = CommsLinkStats{};
+        idlest->lastRxMs = now;
+#if defined(TERMINAL_ENABLED)
+        if (cli != nullptr)
+            cli->printDebugMessage("Idle datagram peer replaced.", LFAST::INFO_MESSAGE);
+#endif
+        return idlest;
+    }
+
+    // The active connection pointer may not survive the vector growing
+    this->activeConnection = nullptr;
+    ClientConnection newPeer(remoteIp, remotePort);
+    newPeer.lastRxMs = now;
+    this->connections.push_back(newPeer);
+    this->connections.back().rxMessageQueue.reserve(MAX_CTRL_MESSAGES);
+#if defined(TERMINAL_ENABLED)
+    if (cli != nullptr)
+        cli->printfDebugMessage("Datagram peer # %d added.\r\n", numPeers + 1);
+#endif
+    return &(this->connections.back());
+}
+
+/// @brief Removes the keys newer carries from older, going into nested objects
+///
+/// A nested object (e.g. a routed destination) is only removed once all of its
+/// own keys have been.
+static void removeSupersededKeys(JsonObject older, JsonObject newer)
+{
+    // Collect first; removing members while iterating the object isn't safe
+    const char *stale[MAX_KV_PAIRS];
+    size_t numStale = 0;
+    for (JsonPair kvp : older)
+    {
+        JsonVariant newVal = newer[kvp.key().c_str()];
+        if (newVal.isNull())
+            continue;
+        if (kvp.value().is<JsonObject>() && newVal.is<JsonObject>())
+        {
+            JsonObject olderObj = kvp.value().as<JsonObject>();
+            removeSupersededKeys(olderObj, newVal.as<JsonObject>());
+            if (olderObj.size() > 0)
+                continue;
+        }
+        if (numStale < MAX_KV_PAIRS)
+            stale[numStale++] = kvp.key().c_str();
+    }
+    for (size_t ii = 0; ii < numStale; ii++)
+        older.remove(stale[ii]);
+}
+
+/// @brief Applies latest-wins semantics to a sequenced datagram
+///
+/// Unsequenced datagrams are always accepted. A sequenced datagram is dropped if
+/// it isn't newer than the last one accepted from the same peer (unless it is so
+/// far behind that the sender must have restarted). Otherwise its keys replace
+/// the same keys in sequenced datagrams from that peer that haven't been
+/// processed yet; a queued datagram is only dropped once it has nothing left.
+///
+/// @return false if the message is stale and should be dropped
+bool LFAST::UdpCommsService::acceptSequencedMessage(ClientConnection &peer, CommsMessageBase *msg)
+{
+    JsonDocument &doc = msg->deserialize(cli);
+    JsonVariant seqVar = doc[UDP_SEQ_KEY];
+    if (seqVar.isNull())
+        return true;
+
+    uint32_t seq = seqVar.as<uint32_t>();
+    doc.remove(UDP_SEQ_KEY);
+    if (peer.rxSeqValid && !seqIsNewer(seq, peer.rxSeqNo) && !seqNeedsResync(seq, peer.rxSeqNo))
+        return false;
+
+    peer.rxSeqNo = seq;
+    peer.rxSeqValid = true;
+
+    JsonObject newRoot = doc.as<JsonObject>();
+    auto itr = peer.rxMessageQueue.begin();
+    while (itr != peer.rxMessageQueue.end())
+    {
+        if (!(*itr)->isLatestWins())
+        {
+            itr++;
+            continue;
+        }
+        JsonObject queuedRoot = (*itr)->getJsonDoc().as<JsonObject>();
+        removeSupersededKeys(queuedRoot, newRoot);
+        if (queuedRoot.size() == 0)
+        {
+            delete *itr;
+            itr = peer.rxMessageQueue.erase(itr);
+        }
+        else
+        {
+            itr++;
+        }
+    }
+    msg->setLatestWinsFlag();
+    return true;
+}
+
+/// @brief Writes a MessagePack map header for numEntries entries
+/// @return header length
+static size_t putMsgPackMapHeader(uint8_t *out, uint32_t numEntries)
+{
+    if (numEntries < 16)
+    {
+        out[0] = 0x80 | numEntries;
+        return 1;
+    }
+    if (numEntries <= 0xFFFF)
+    {
+        out[0] = 0xDE;
+        out[1] = numEntries >> 8;
+        out[2] = numEntries;
+        return 3;
+    }
+    out[0] = 0xDF;
+    for (int ii = 0; ii < 4; ii++)
+        out[1 + ii] = numEntries >> (24 - 8 * ii);
+    return 5;
+}
+
+/// @brief Sends a message as one datagram, with the peer's next sequence number added
+///
+/// The sequence number goes into the serialized output, ahead of the message's
+/// own keys, so the caller's document is left as it was (and can be sent again,
+/// e.g. to every peer).
+void LFAST::UdpCommsService::sendDatagram(CommsMessageBase &msg, ClientConnection &peer)
+{
+    static uint8_t payload[LARGE_MSG_BUFF_SIZE];
+    static uint8_t header[24];
+    JsonDocument &doc = msg.getJsonDoc();
+    uint32_t seq = peer.txSeqNo++;
+
+#if defined(TERMINAL_ENABLED)
+    if (cli != nullptr)
+    {
+        char msgBuff[JSON_PROGMEM_SIZE]{0};
+        msg.getMessageStr(msgBuff);
+        cli->updatePersistentField(infoFields[MESSAGE_SENT_ROW], msgBuff);
+    }
+#endif
+
+    size_t payloadLen = 0;
+    size_t headerLen = 0;
+    size_t bodyStart = 0;
+    if (peer.binaryPeer)
+    {
+        if (measureMsgPack(doc) <= sizeof(payload))
+            payloadLen = serializeMsgPack(doc, payload, sizeof(payload));
+        // Replace the map header with one counting the extra entry
+        uint32_t numEntries = 0;
+        if (payloadLen >= 1 && (payload[0] & 0xF0) == 0x80)
+        {
+            numEntries = payload[0] & 0x0F;
+            bodyStart = 1;
+        }
+        else if (payloadLen >= 3 && payload[0] == 0xDE)
+        {
+            numEntries = (payload[1] << 8) | payload[2];
+            bodyStart = 3;
+        }
+        else if (payloadLen >= 5 && payload[0] == 0xDF)
+        {
+            numEntries = ((uint32_t)payload[1] << 24) | ((uint32_t)payload[2] << 16) | (payload[3] << 8) | payload[4];
+            bodyStart = 5;
+        }
+        else
+        {
+            payloadLen = 0;
+        }
+        if (payloadLen > 0)
+        {
+            headerLen = putMsgPackMapHeader(header, numEntries + 1);
+            header[headerLen++] = 0xA0 | (sizeof(UDP_SEQ_KEY) - 1);
+            std::memcpy(header + headerLen, UDP_SEQ_KEY, sizeof(UDP_SEQ_KEY) - 1);
+            headerLen += sizeof(UDP_SEQ_KEY) - 1;
+            header[headerLen++] = 0xCE;
+            for (int ii = 0; ii < 4; ii++)
+                header[headerLen++] = seq >> (24 - 8 * ii);
+        }
+    }
+    else
+    {
+        if (measureJson(doc) < sizeof(payload))
+            payloadLen = serializeJson(doc, (char *)payload, sizeof(payload));
+        if (payloadLen >= 2 && payload[0] == '{')
+        {
+            bool empty = (payload[1] == '}');
+            headerLen = snprintf((char *)header, sizeof(header), "{\"" UDP_SEQ_KEY "\":%lu%s",
+                                 (unsigned long)seq, empty ? "" : ",");
+            bodyStart = 1;
+        }
+        else
+        {
+            payloadLen = 0;
+        }
+    }
+
+    if (payloadLen == 0)
+    {
+        recordTx(&peer, msg, 0);
+#if defined(TERMINAL_ENABLED)
+        if (cli != nullptr)
+            cli->printDebugMessage("Message too large for a datagram.", LFAST::ERROR_MESSAGE);
+#endif
+        return;
+    }
+
+    udp.beginPacket(peer.remoteIp, peer.remotePort);
+    udp.write(header, headerLen);
+    udp.write(payload + bodyStart, payloadLen - bodyStart);
+    udp.endPacket();
+    recordTx(&peer, msg, headerLen + payloadLen - bodyStart);
+}
@@ -0,0 +1,278 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file capture_replay_bench.cc
+///
+/// Replays a frame capture (see FrameCapture.h) through the comms library's
+/// own framers and dispatcher on the host, so recorded production traffic can
+/// be used as a repeatable benchmark. Each captured connection becomes a link
+/// of its own, fed from memory:
+///
+///   tcp     frames go through the brace-counting stream framer, like a TCP
+///           client. JSON only, so captures holding MessagePack are refused.
+///   serial  frames are COBS encoded and go through SerialCommsService's
+///           decoder. Takes JSON and MessagePack.
+///
+/// Every frame is followed by one checkForNewClientData()/processClientData()
+/// pass, like a loop tick. In max mode frames go back to back; in realtime
+/// mode each waits for its captured timestamp. PMCMessage tip/tilt/focus/move
+/// keys have (counting) handlers; other keys go through the lookup and the
+/// default handler.
+///
+/// ./capture_replay_bench capture.bin [tcp|serial] [max|realtime] [connId]
+
+#include "../include/SerialCommsService.h"
+#include "../include/FrameCapture.h"
+#include "../include/cobs_framing.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief In-memory byte stream; the replay appends frames, the framer reads them
+class ReplayStream : public Stream
+{
+public:
+    void append(const uint8_t *data, size_t len) { rx.insert(rx.end(), data, data + len); }
+
+    int available() override { return (int)(rx.size() - pos); }
+    int read() override
+    {
+        if (pos >= rx.size())
+            return -1;
+        int c = rx[pos++];
+        if (pos == rx.size())
+        {
+            rx.clear();
+            pos = 0;
+        }
+        return c;
+    }
+    int peek() override { return (pos < rx.size()) ? rx[pos] : -1; }
+    // Replies are counted and thrown away
+    using Print::write;
+    size_t write(uint8_t) override
+    {
+        bytesOut++;
+        return 1;
+    }
+    size_t write(const uint8_t *, size_t size) override
+    {
+        bytesOut += size;
+        return size;
+    }
+
+    size_t bytesOut = 0;
+
+private:
+    std::vector<uint8_t> rx;
+    size_t pos = 0;
+};
+
+/// @brief A ReplayStream as a TCP-style client
+///
+/// Only "connected" while it has bytes, since the stream framer waits for a
+/// whole object as long as its client is connected.
+class ReplayClient : public Client
+{
+public:
+    int connect(IPAddress, uint16_t) override { return 0; }
+    int connect(const char *, uint16_t) override { return 0; }
+    size_t write(uint8_t b) override { return stream.write(b); }
+    size_t write(const uint8_t *buf, size_t size) override { return stream.write(buf, size); }
+    int available() override { return stream.available(); }
+    int read() override { return stream.read(); }
+    int read(uint8_t *buf, size_t size) override { return stream.readBytes((char *)buf, size); }
+    int peek() override { return stream.peek(); }
+    void flush() override {}
+    void stop() override {}
+    uint8_t connected() override { return stream.available() > 0; }
+    operator bool() override { return true; }
+
+    ReplayStream stream;
+};
+
+class ReplayService : public LFAST::SerialCommsService
+{
+public:
+    ReplayService(bool _serial) : serial(_serial) {}
+
+    /// @brief Hands a captured frame to its connection's framer
+    /// @return false if the link couldn't be added
+    bool feed(uint16_t connId, const uint8_t *payload, size_t len)
+    {
+        ReplayStream *stream = linkFor(connId);
+        if (stream == nullptr)
+            return false;
+        if (!serial)
+        {
+            stream->append(payload, len);
+            return true;
+        }
+        std::vector<uint8_t> frame(LFAST::cobsMaxEncodedLength(len) + 1);
+        size_t frameLen = LFAST::cobsEncode(payload, len, frame.data());
+        frame[frameLen++] = 0;
+        stream->append(frame.data(), frameLen);
+        return true;
+    }
+
+    size_t bytesOut()
+    {
+        size_t total = 0;
+        for (auto &client : clients)
+            total += client.second->stream.bytesOut;
+        return total;
+    }
+    const LFAST::CommsLinkStats &totals() { return commsStats.totals; }
+
+private:
+    ReplayStream *linkFor(uint16_t connId)
+    {
+        auto itr = clients.find(connId);
+        if (itr != clients.end())
+            return &itr->second->stream;
+        ReplayClient *client = new ReplayClient();
+        bool added = true;
+        if (serial)
+            added = addSerialLink(client->stream);
+        else
+            setupClientMessageBuffers(client);
+        if (!added)
+        {
+            delete client;
+            return nullptr;
+        }
+        clients[connId].reset(client);
+        return &client->stream;
+    }
+
+    bool serial;
+    // Serial links hold a reference to the stream, so these live as long as the service
+    std::map<uint16_t, std::unique_ptr<ReplayClient>> clients;
+};
+
+static unsigned long handlerCalls = 0;
+static void countDouble(double) { handlerCalls++; }
+static void countInt(int) { handlerCalls++; }
+
+static bool isJson(const uint8_t *payload, size_t len)
+{
+    // Same test the device uses (CommsMessageBase::setInputLength)
+    if (len == 0)
+        return false;
+    uint8_t c0 = payload[0];
+    return c0 == '{' || c0 == ' ' || c0 == '\r' || c0 == '\n' || c0 == '\t';
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s capture.bin [tcp|serial] [max|realtime] [connId]\n", argv[0]);
+        return 1;
+    }
+    bool serial = (argc > 2) && std::strcmp(argv[2], "serial") == 0;
+    bool realtime = (argc > 3) && std::strcmp(argv[3], "realtime") == 0;
+    long onlyConn = (argc > 4) ? std::strtol(argv[4], nullptr, 0) : -1;
+
+    FILE *file = std::fopen(argv[1], "rb");
+    if (file == nullptr)
+    {
+        std::perror(argv[1]);
+        return 1;
+    }
+    std::vector<uint8_t> capture;
+    uint8_t buff[4096];
+    size_t n;
+    while ((n = std::fread(buff, 1, sizeof(buff), file)) > 0)
+        capture.insert(capture.end(), buff, buff + n);
+    std::fclose(file);
+
+    LFAST::FrameCaptureReader reader(capture.data(), capture.size());
+    if (!reader.valid())
+    {
+        std::fprintf(stderr, "%s is not a version %d frame capture\n", argv[1], CAPTURE_FORMAT_VERSION);
+        return 1;
+    }
+    std::vector<LFAST::CaptureRecord> records;
+    LFAST::CaptureRecord rec;
+    while (reader.next(rec))
+    {
+        if (onlyConn < 0 || rec.connectionId == onlyConn)
+            records.push_back(rec);
+    }
+    if (records.empty())
+    {
+        std::fprintf(stderr, "no records to replay\n");
+        return 1;
+    }
+    if (!serial)
+    {
+        size_t binary = 0;
+        for (auto &r : records)
+            binary += isJson(r.payload, r.length) ? 0 : 1;
+        if (binary > 0)
+        {
+            std::fprintf(stderr, "%zu of %zu frames are MessagePack, which the tcp framer can't split; use serial\n",
+                         binary, records.size());
+            return 1;
+        }
+    }
+
+    ReplayService service(serial);
+    service.registerMessageHandler<double>("PMCMessage", "SetTip", countDouble);
+    service.registerMessageHandler<double>("PMCMessage", "SetTilt", countDouble);
+    service.registerMessageHandler<double>("PMCMessage", "SetFocus", countDouble);
+    service.registerMessageHandler<int>("PMCMessage", "MoveType", countInt);
+
+    size_t bytesIn = 0;
+    unsigned long skipped = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto &r : records)
+    {
+        if (realtime)
+        {
+            // Timestamps are micros() and wrap every ~71 minutes
+            uint32_t offsetUs = r.timestampUs - records[0].timestampUs;
+            std::this_thread::sleep_until(start + std::chrono::microseconds(offsetUs));
+        }
+        if (!service.feed(r.connectionId, r.payload, r.length))
+        {
+            skipped++;
+            continue;
+        }
+        bytesIn += r.length;
+        service.checkForNewClientData();
+        service.processClientData();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const LFAST::CommsLinkStats &totals = service.totals();
+    std::printf("%s framer, %s: %zu frames, %zu bytes in %.3f s (%.0f frames/s, %.2f us/frame)\n",
+                serial ? "serial" : "tcp", realtime ? "realtime" : "max", records.size() - skipped, bytesIn,
+                seconds, (records.size() - skipped) / seconds, 1e6 * seconds / (records.size() - skipped));
+    std::printf("framed %lu, dropped %lu, parse errors %lu, handler calls %lu, reply bytes %zu\n",
+                (unsigned long)totals.framesIn, (unsigned long)totals.droppedFrames,
+                (unsigned long)totals.parseErrors, handlerCalls, service.bytesOut());
+    if (skipped > 0)
+        std::printf("%lu frames skipped: more connections than MAX_SERIAL_LINKS\n", skipped);
+    return 0;
+}
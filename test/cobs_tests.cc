@@ -0,0 +1,99 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file cobs_tests.cc
+///
+
+#include "../include/cobs_framing.h"
+#include <cstring>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace LFAST;
+
+static std::vector<uint8_t> encode(const std::vector<uint8_t> &in)
+{
+    std::vector<uint8_t> out(cobsMaxEncodedLength(in.size()));
+    out.resize(cobsEncode(in.data(), in.size(), out.data()));
+    return out;
+}
+
+TEST(cobs_tests, testKnownVectors)
+{
+    EXPECT_EQ(encode({0x00}), (std::vector<uint8_t>{0x01, 0x01}));
+    EXPECT_EQ(encode({0x00, 0x00}), (std::vector<uint8_t>{0x01, 0x01, 0x01}));
+    EXPECT_EQ(encode({0x11, 0x22, 0x00, 0x33}), (std::vector<uint8_t>{0x03, 0x11, 0x22, 0x02, 0x33}));
+    EXPECT_EQ(encode({0x11, 0x00, 0x00, 0x00}), (std::vector<uint8_t>{0x02, 0x11, 0x01, 0x01, 0x01}));
+}
+
+TEST(cobs_tests, testRoundTripLongRuns)
+{
+    for (size_t len : {1u, 253u, 254u, 255u, 600u})
+    {
+        std::vector<uint8_t> in(len);
+        for (size_t ii = 0; ii < len; ii++)
+            in[ii] = (ii % 7 == 3) ? 0 : (uint8_t)(ii + 1);
+        auto enc = encode(in);
+        for (auto b : enc)
+            ASSERT_NE(b, 0);
+        std::vector<uint8_t> dec(len);
+        ASSERT_EQ(cobsDecode(enc.data(), enc.size(), dec.data(), dec.size()), len);
+        EXPECT_EQ(dec, in);
+    }
+}
+
+TEST(cobs_tests, testStreamDecoderChunked)
+{
+    std::string msgs[] = {"{\"Handshake\":57005}", "{\"PMCMessage\":{\"SetTip\":0.01}}"};
+    std::vector<uint8_t> stream;
+    for (auto &m : msgs)
+    {
+        auto enc = encode(std::vector<uint8_t>(m.begin(), m.end()));
+        stream.insert(stream.end(), enc.begin(), enc.end());
+        stream.push_back(0);
+    }
+
+    CobsFrameDecoder<64> decoder;
+    std::vector<std::string> frames;
+    auto onFrame = [&](const uint8_t *f, size_t n)
+    { frames.emplace_back((const char *)f, n); };
+    // Feed three bytes at a time so frames straddle reads
+    for (size_t ii = 0; ii < stream.size(); ii += 3)
+        decoder.feed(stream.data() + ii, std::min<size_t>(3, stream.size() - ii), onFrame);
+
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[0], msgs[0]);
+    EXPECT_EQ(frames[1], msgs[1]);
+    EXPECT_EQ(decoder.errors(), 0u);
+}
+
+TEST(cobs_tests, testStreamDecoderResyncsAfterOversizedFrame)
+{
+    std::vector<uint8_t> big(100, 'x');
+    std::vector<uint8_t> small = {'{', '}'};
+    std::vector<uint8_t> stream = encode(big);
+    stream.push_back(0);
+    auto enc = encode(small);
+    stream.insert(stream.end(), enc.begin(), enc.end());
+    stream.push_back(0);
+
+    CobsFrameDecoder<16> decoder;
+    unsigned int count = 0;
+    decoder.feed(stream.data(), stream.size(), [&](const uint8_t *f, size_t n)
+                 { count++; EXPECT_EQ(std::string((const char *)f, n), "{}"); });
+    EXPECT_EQ(count, 1u);
+    EXPECT_EQ(decoder.errors(), 1u);
+}
@@ -0,0 +1,155 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file data_logger_bench.cc
+///
+/// Host benchmark for DataLogger writing to a regular file.
+///  - Sustained: logs records back to back, calling service() after each,
+///    and reports records/sec and drops.
+///  - Loop impact: a 1 kHz loop logging one record per tick, timing the
+///    logging work in each tick (mean / p99 / max). It runs once with the
+///    double buffered logger and once writing and flushing every record
+///    directly, which is what logging without the buffers costs.
+///
+/// ./data_logger_bench [seconds] [loopHz]
+
+#include "../include/DataLogger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+struct Telemetry
+{
+    uint32_t timestampUs;
+    float position[6];
+    float command[6];
+    float current[6];
+    uint32_t flags;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+/// Unbuffered, so each sink write is one write() syscall, like one SD block write
+static FILE *openLogFile()
+{
+    FILE *file = tmpfile();
+    if (file == nullptr)
+    {
+        perror("tmpfile");
+        std::exit(1);
+    }
+    setvbuf(file, nullptr, _IONBF, 0);
+    return file;
+}
+
+static double elapsedUs(Clock::time_point start, Clock::time_point stop)
+{
+    return std::chrono::duration<double, std::micro>(stop - start).count();
+}
+
+static void runSustained(double seconds)
+{
+    FILE *file = openLogFile();
+    LFAST::FileCaptureSink sink(file);
+    LFAST::DataLogger logger(sink, sizeof(Telemetry));
+    Telemetry rec = {};
+
+    auto start = Clock::now();
+    auto stop = start + std::chrono::duration<double>(seconds);
+    uint32_t ii = 0;
+    while (Clock::now() < stop)
+    {
+        rec.timestampUs = ii++;
+        logger.log(&rec);
+        logger.service();
+    }
+    logger.close();
+    double sec = elapsedUs(start, Clock::now()) * 1e-6;
+    std::printf("sustained: %.0f records/s (%.1f MB/s), %u dropped of %u\n",
+                logger.recordsLogged() / sec, logger.recordsLogged() * sizeof(Telemetry) / sec / 1e6,
+                logger.recordsDropped(), ii);
+    fclose(file);
+}
+
+static void printLoopStats(const char *name, std::vector<double> &samples, uint32_t dropped)
+{
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double s : samples)
+        sum += s;
+    std::printf("%-16s %10.2f %10.2f %10.2f %10u\n", name, sum / samples.size(),
+                samples[samples.size() * 99 / 100], samples.back(), dropped);
+}
+
+template <typename LogFn>
+static std::vector<double> runLoop(double seconds, unsigned int loopHz, LogFn logOne)
+{
+    size_t numLoops = (size_t)(seconds * loopHz);
+    std::vector<double> samples;
+    samples.reserve(numLoops);
+    auto period = std::chrono::nanoseconds(1000000000ULL / loopHz);
+    auto next = Clock::now();
+    Telemetry rec = {};
+    for (size_t ii = 0; ii < numLoops; ii++)
+    {
+        rec.timestampUs = (uint32_t)ii;
+        auto t0 = Clock::now();
+        logOne(rec);
+        samples.push_back(elapsedUs(t0, Clock::now()));
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
+    return samples;
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = (argc > 1) ? std::atof(argv[1]) : 2.0;
+    unsigned int loopHz = (argc > 2) ? std::atoi(argv[2]) : 1000;
+
+    std::printf("%zu byte records, %u byte blocks, 2 x %u byte buffers\n",
+                sizeof(Telemetry), DATA_LOG_BLOCK_SIZE, DATA_LOG_BUFFER_SIZE);
+    runSustained(seconds);
+
+    std::printf("\n%u Hz loop, %.1f s, time spent logging per tick (us)\n", loopHz, seconds);
+    std::printf("%-16s %10s %10s %10s %10s\n", "logger", "mean", "p99", "max", "dropped");
+    {
+        FILE *file = openLogFile();
+        LFAST::FileCaptureSink sink(file);
+        LFAST::DataLogger logger(sink, sizeof(Telemetry));
+        std::vector<double> samples = runLoop(seconds, loopHz, [&](const Telemetry &rec) {
+            logger.log(&rec);
+            logger.service();
+        });
+        logger.close();
+        printLoopStats("double buffered", samples, logger.recordsDropped());
+        fclose(file);
+    }
+    {
+        FILE *file = openLogFile();
+        LFAST::FileCaptureSink sink(file);
+        std::vector<double> samples = runLoop(seconds, loopHz, [&](const Telemetry &rec) {
+            sink.write((const uint8_t *)&rec, sizeof(rec));
+            sink.flush();
+        });
+        printLoopStats("direct", samples, 0);
+        fclose(file);
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file data_logger_tests.cc
+///
+
+
+#include "../include/DataLogger.h"
+#include <cstring>
+#include <vector>
+#include <gtest/gtest.h>
+#include "vector_sink.h"
+
+using namespace LFAST;
+
+struct Telemetry
+{
+    uint32_t timestampUs;
+    float position[3];
+    float command[3];
+    uint32_t flags;
+};
+
+static Telemetry makeRecord(uint32_t ii)
+{
+    Telemetry rec;
+    rec.timestampUs = ii * 1000;
+    for (int jj = 0; jj < 3; jj++)
+    {
+        rec.position[jj] = ii + 0.25f * jj;
+        rec.command[jj] = -(float)ii;
+    }
+    rec.flags = ii ^ 0xA5A5;
+    return rec;
+}
+
+TEST(data_logger_tests, testRoundTrip)
+{
+    VectorSink sink;
+    DataLogger logger(sink, sizeof(Telemetry));
+    const uint32_t numRecords = 2000;
+    for (uint32_t ii = 0; ii < numRecords; ii++)
+    {
+        Telemetry rec = makeRecord(ii);
+        ASSERT_TRUE(logger.log(&rec));
+        logger.service();
+    }
+    logger.close();
+    EXPECT_EQ(logger.recordsLogged(), numRecords);
+    EXPECT_EQ(logger.recordsDropped(), 0U);
+
+    ASSERT_EQ(sink.bytes.size(), DATA_LOG_HEADER_SIZE + numRecords * sizeof(Telemetry));
+    EXPECT_EQ(std::memcmp(sink.bytes.data(), "LFLOG", 5), 0);
+    EXPECT_EQ(sink.bytes[7] | (sink.bytes[8] << 8), (int)sizeof(Telemetry));
+    for (uint32_t ii = 0; ii < numRecords; ii++)
+    {
+        Telemetry rec;
+        std::memcpy(&rec, &sink.bytes[DATA_LOG_HEADER_SIZE + ii * sizeof(Telemetry)], sizeof(rec));
+        Telemetry expected = makeRecord(ii);
+        ASSERT_EQ(std::memcmp(&rec, &expected, sizeof(rec)), 0) << "record " << ii;
+    }
+}
+
+TEST(data_logger_tests, testWholeBlockWrites)
+{
+    VectorSink sink;
+    DataLogger logger(sink, sizeof(Telemetry));
+    for (uint32_t ii = 0; ii < 3000; ii++)
+    {
+        Telemetry rec = makeRecord(ii);
+        logger.log(&rec);
+        EXPECT_LE(logger.service(1), 1U);
+    }
+    // Everything before close() goes out in whole blocks
+    for (size_t len : sink.writeSizes)
+        EXPECT_EQ(len, (size_t)DATA_LOG_BLOCK_SIZE);
+    logger.close();
+    EXPECT_EQ(sink.bytes.size(), DATA_LOG_HEADER_SIZE + 3000 * sizeof(Telemetry));
+}
+
+TEST(data_logger_tests, testDropsWhenNotServiced)
+{
+    VectorSink sink;
+    DataLogger logger(sink, sizeof(Telemetry));
+    uint32_t accepted = 0;
+    for (uint32_t ii = 0; ii < 2000; ii++)
+    {
+        Telemetry rec = makeRecord(ii);
+        if (logger.log(&rec))
+            accepted++;
+    }
+    // Both buffers fill up, less the header
+    EXPECT_EQ(accepted, (2 * DATA_LOG_BUFFER_SIZE - DATA_LOG_HEADER_SIZE) / sizeof(Telemetry));
+    EXPECT_EQ(logger.recordsDropped(), 2000 - accepted);
+    EXPECT_TRUE(sink.bytes.empty());
+
+    // Once the full buffer is written there's room again
+    logger.service(DATA_LOG_BUFFER_BLOCKS);
+    Telemetry rec = makeRecord(0);
+    EXPECT_TRUE(logger.log(&rec));
+}
+
+TEST(data_logger_tests, testExactFillKeepsPendingBuffer)
+{
+    // 16 byte records divide the buffers evenly, so a record can end exactly at a buffer's end
+    VectorSink sink;
+    DataLogger logger(sink, 16);
+    uint8_t rec[16];
+    uint32_t accepted = 0;
+    for (uint32_t ii = 0; ii < 2 * DATA_LOG_BUFFER_SIZE / 16; ii++)
+    {
+        std::memset(rec, ii & 0xFF, sizeof(rec));
+        if (!logger.log(rec))
+            break;
+        accepted++;
+    }
+    // The last free buffer is never filled completely
+    EXPECT_EQ(accepted, (2 * DATA_LOG_BUFFER_SIZE - DATA_LOG_HEADER_SIZE) / 16 - 1);
+    logger.close();
+    ASSERT_EQ(sink.bytes.size(), DATA_LOG_HEADER_SIZE + accepted * 16);
+    for (uint32_t ii = 0; ii < accepted; ii++)
+        ASSERT_EQ(sink.bytes[DATA_LOG_HEADER_SIZE + ii * 16], ii & 0xFF) << "record " << ii;
+}
+
+TEST(data_logger_tests, testRejectsOversizedRecords)
+{
+    VectorSink sink;
+    DataLogger logger(sink, DATA_LOG_BUFFER_SIZE + 1);
+    std::vector<uint8_t> rec(DATA_LOG_BUFFER_SIZE + 1, 0x55);
+    EXPECT_FALSE(logger.log(rec.data()));
+    EXPECT_EQ(logger.recordsDropped(), 1U);
+    logger.close();
+    EXPECT_TRUE(sink.bytes.empty());
+}
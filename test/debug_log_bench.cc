@@ -0,0 +1,121 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file debug_log_bench.cc
+///
+/// Per-message cost of formatting and storing a debug log line, before and
+/// after TerminalInterface stopped using the heap for it. "stream" is the old
+/// path (stringstream + iomanip, color std::string, deque<std::string> of the
+/// last 15 lines); "fixed" is formatDebugLine() into a ring of char arrays.
+/// Heap allocations are counted by replacing the global operator new.
+///
+/// ./debug_log_bench [numMessages]
+
+#include "../include/TerminalFormat.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <string>
+
+static unsigned long allocCount = 0;
+
+void *operator new(size_t size)
+{
+    allocCount++;
+    void *p = std::malloc(size ? size : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+#define BENCH_DEBUG_ROWS 15
+#define BENCH_LINE_CHARS 148
+
+static const char *colors[] = {"\033[37m", "\033[32m", "\033[33m", "\033[31m"};
+static const char *sampleMsg = "Unregistered Message: [SetTipTiltFocusSomething].";
+
+struct Result
+{
+    double nsPerMsg;
+    double allocsPerMsg;
+};
+
+static Result runStream(unsigned int numMsgs, std::string &lastLine)
+{
+    std::deque<std::string> lines;
+    unsigned long allocsBefore = allocCount;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int ii = 0; ii < numMsgs; ii++)
+    {
+        std::string colorStr = colors[ii & 3];
+        std::stringstream ss;
+        ss << std::setiosflags(std::ios::left) << std::setw(12);
+        ss << "\033[37m" << (uint16_t)(ii + 1) << "[" << (unsigned long)ii * 3 << "]: " << colorStr << sampleMsg;
+        std::string line = ss.str();
+        if (lines.size() == BENCH_DEBUG_ROWS)
+            lines.pop_front();
+        lines.push_back(line);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    lastLine = lines.back();
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    return {ns / numMsgs, (double)(allocCount - allocsBefore) / numMsgs};
+}
+
+static Result runFixed(unsigned int numMsgs, std::string &lastLine)
+{
+    static char lines[BENCH_DEBUG_ROWS][BENCH_LINE_CHARS];
+    unsigned int head = 0;
+    unsigned long allocsBefore = allocCount;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int ii = 0; ii < numMsgs; ii++)
+    {
+        char *line = lines[head];
+        head = (head + 1) % BENCH_DEBUG_ROWS;
+        LFAST::formatDebugLine(line, BENCH_LINE_CHARS, (uint16_t)(ii + 1), (unsigned long)ii * 3, colors[ii & 3], sampleMsg);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    unsigned long allocs = allocCount - allocsBefore;
+    lastLine = lines[(head + BENCH_DEBUG_ROWS - 1) % BENCH_DEBUG_ROWS];
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    return {ns / numMsgs, (double)allocs / numMsgs};
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int numMsgs = (argc > 1) ? std::atoi(argv[1]) : 200000;
+    std::string streamLine, fixedLine;
+
+    Result stream = runStream(numMsgs, streamLine);
+    Result fixed = runFixed(numMsgs, fixedLine);
+    if (streamLine != fixedLine)
+    {
+        std::printf("Output mismatch:\n  stream: %s\n  fixed:  %s\n", streamLine.c_str(), fixedLine.c_str());
+        return 1;
+    }
+
+    std::printf("%u messages\n", numMsgs);
+    std::printf("%-8s %10s %12s\n", "path", "ns/msg", "allocs/msg");
+    std::printf("%-8s %10.1f %12.2f\n", "stream", stream.nsPerMsg, stream.allocsPerMsg);
+    std::printf("%-8s %10.1f %12.2f\n", "fixed", fixed.nsPerMsg, fixed.allocsPerMsg);
+    return 0;
+}
@@ -0,0 +1,34 @@
+# deferred_log_roundtrip.py
+#
+# Checks that scripts/deferred_log/decode_log.py, with the table from
+# make_format_table.py, turns the log written by deferred_log_sample back into
+# exactly the text printf gives for the same calls.
+#
+#   python deferred_log_roundtrip.py ./deferred_log_sample deferred_log_table.json
+
+import os
+import subprocess
+import sys
+import tempfile
+
+SCRIPT_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "scripts", "deferred_log")
+
+if __name__ == "__main__":
+    sample, table = sys.argv[1], sys.argv[2]
+    with tempfile.TemporaryDirectory() as tmp:
+        log = os.path.join(tmp, "log.bin")
+        expectedPath = os.path.join(tmp, "expected.txt")
+        subprocess.run([sample, log, expectedPath], check=True)
+        decoded = subprocess.run([sys.executable, os.path.join(SCRIPT_DIR, "decode_log.py"), table, log],
+                                 check=True, capture_output=True, text=True).stdout.splitlines()
+        with open(expectedPath) as f:
+            expected = f.read().splitlines()
+
+    # Drop the timestamp column ("%12.6f  ")
+    decoded = [line[14:] for line in decoded]
+    if decoded != expected:
+        for want, got in zip(expected, decoded):
+            print(f"{'ok ' if want == got else 'BAD'} {want!r} / {got!r}")
+        print(f"{len(expected)} expected, {len(decoded)} decoded")
+        sys.exit(1)
+    print(f"{len(expected)} records round trip")
@@ -0,0 +1,83 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file deferred_log_sample.cc
+///
+/// Writes a deferred log, plus the same messages formatted here with printf,
+/// for deferred_log_roundtrip.py to check decode_log.py against. Every format
+/// appears twice below, since make_format_table.py only finds literal
+/// DEFERRED_LOG() calls.
+///
+/// ./deferred_log_sample log.bin expected.txt
+
+#include "../include/DeferredLog.h"
+
+#include <cstdint>
+#include <cstdio>
+
+template <typename... Args>
+static void expect(FILE *file, const char *fmt, Args... args)
+{
+    std::fprintf(file, fmt, args...);
+    std::fputc('\n', file);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::fprintf(stderr, "usage: %s log.bin expected.txt\n", argv[0]);
+        return 1;
+    }
+    FILE *logFile = std::fopen(argv[1], "wb");
+    FILE *expected = std::fopen(argv[2], "w");
+    if (logFile == nullptr || expected == nullptr)
+    {
+        std::perror("fopen");
+        return 1;
+    }
+
+    LFAST::DeferredLog<4096> log;
+    int32_t axis = 2;
+    uint32_t steps = 4000000000u;
+    int64_t offset = -1234567890123LL;
+    uint64_t ticks = 0x123456789ABCULL;
+    float tip = 0.0349f;
+    double focus = -10.125;
+
+    DEFERRED_LOG(log, "axis %d moved %u steps", axis, steps);
+    expect(expected, "axis %d moved %u steps", axis, steps);
+    DEFERRED_LOG(log, "offset %lld ticks %llx", (long long)offset, (unsigned long long)ticks);
+    expect(expected, "offset %lld ticks %llx", (long long)offset, (unsigned long long)ticks);
+    DEFERRED_LOG(log, "tip %.4f focus %8.3f", tip, focus);
+    expect(expected, "tip %.4f focus %8.3f", (double)tip, focus);
+    DEFERRED_LOG(log, "state %s, code 0x%04X", "TRACKING", 0xBEEF);
+    expect(expected, "state %s, code 0x%04X", "TRACKING", 0xBEEF);
+    DEFERRED_LOG(log, "split "
+                      "literal\t%d%%",
+                 95);
+    expect(expected, "split "
+                     "literal\t%d%%",
+           95);
+    DEFERRED_LOG(log, "no arguments");
+    expect(expected, "no arguments");
+
+    LFAST::FileCaptureSink sink(logFile);
+    while (log.drain(sink, 4096) > 0)
+        ;
+    std::fclose(logFile);
+    std::fclose(expected);
+    return 0;
+}
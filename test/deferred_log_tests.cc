@@ -0,0 +1,114 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file deferred_log_tests.cc
+///
+
+
+#include "../include/DeferredLog.h"
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "vector_sink.h"
+
+using namespace LFAST;
+
+static uint32_t get32(const std::vector<uint8_t> &b, size_t pos)
+{
+    return b[pos] | (b[pos + 1] << 8) | (b[pos + 2] << 16) | ((uint32_t)b[pos + 3] << 24);
+}
+
+TEST(deferred_log_tests, testFormatId)
+{
+    // Reference FNV-1a values
+    static_assert(deferredLogId("") == 0x811C9DC5u, "empty string");
+    static_assert(deferredLogId("a") == 0xE40C292Cu, "single char");
+    EXPECT_EQ(deferredLogId("foobar"), 0xBF9CF968u);
+}
+
+TEST(deferred_log_tests, testRecordLayout)
+{
+    DeferredLog<256> log;
+    VectorSink sink;
+    int32_t neg = -2;
+    uint64_t big = 0x123456789ULL;
+    ASSERT_TRUE(DEFERRED_LOG(log, "%d %llu %f %s", neg, big, 1.5, "axis"));
+    log.drain(sink, 1000);
+
+    const std::vector<uint8_t> &b = sink.bytes;
+    ASSERT_EQ(b.size(), DEFERRED_LOG_HEADER_SIZE + 5 + 9 + 9 + 6);
+    EXPECT_EQ(b[0], DEFERRED_LOG_SYNC);
+    EXPECT_EQ(b[1], 5 + 9 + 9 + 6);
+    EXPECT_EQ(get32(b, 2), deferredLogId("%d %llu %f %s"));
+    size_t pos = DEFERRED_LOG_HEADER_SIZE;
+    EXPECT_EQ(b[pos], 'i');
+    EXPECT_EQ(get32(b, pos + 1), 0xFFFFFFFEu);
+    pos += 5;
+    EXPECT_EQ(b[pos], 'Q');
+    EXPECT_EQ(get32(b, pos + 1), 0x23456789u);
+    EXPECT_EQ(get32(b, pos + 5), 0x1u);
+    pos += 9;
+    EXPECT_EQ(b[pos], 'd');
+    double dbl;
+    std::memcpy(&dbl, &b[pos + 1], sizeof(dbl));
+    EXPECT_EQ(dbl, 1.5);
+    pos += 9;
+    EXPECT_EQ(b[pos], 's');
+    EXPECT_EQ(b[pos + 1], 4);
+    EXPECT_EQ(std::string((const char *)&b[pos + 2], 4), "axis");
+}
+
+TEST(deferred_log_tests, testFullLogDropsWholeRecords)
+{
+    DeferredLog<32> log;
+    EXPECT_TRUE(log.record(1, 0, 1, 2));
+    EXPECT_TRUE(log.record(2, 0));
+    // 10 + 5 more would overflow 32 bytes
+    EXPECT_FALSE(log.record(3, 0, 7));
+    EXPECT_EQ(log.pending(), (size_t)(DEFERRED_LOG_HEADER_SIZE * 2 + 10));
+    EXPECT_EQ(log.recordCount(), 2U);
+    EXPECT_EQ(log.droppedRecords(), 1U);
+
+    std::string longStr(100, 'x');
+    DeferredLog<64> strLog;
+    EXPECT_TRUE(strLog.record(4, 0, longStr.c_str()));
+    EXPECT_EQ(strLog.pending(), (size_t)(DEFERRED_LOG_HEADER_SIZE + 2 + DEFERRED_LOG_MAX_STR));
+}
+
+TEST(deferred_log_tests, testDrainWrapsAndRetries)
+{
+    DeferredLog<64> log;
+    VectorSink sink;
+    std::vector<uint8_t> expected;
+    for (uint32_t ii = 0; ii < 20; ii++)
+    {
+        ASSERT_TRUE(log.record(ii, ii * 10, ii));
+        // A sink that refuses a write keeps everything queued
+        sink.failWrites = (ii == 5);
+        log.drain(sink, 7);
+        log.drain(sink, 100);
+    }
+    sink.failWrites = false;
+    log.drain(sink, 1000);
+    ASSERT_EQ(sink.bytes.size(), 20U * (DEFERRED_LOG_HEADER_SIZE + 5));
+    for (uint32_t ii = 0; ii < 20; ii++)
+    {
+        size_t pos = ii * (DEFERRED_LOG_HEADER_SIZE + 5);
+        EXPECT_EQ(sink.bytes[pos], DEFERRED_LOG_SYNC);
+        EXPECT_EQ(get32(sink.bytes, pos + 2), ii);
+        EXPECT_EQ(get32(sink.bytes, pos + 6), ii * 10);
+        EXPECT_EQ(get32(sink.bytes, pos + 11), ii);
+    }
+}
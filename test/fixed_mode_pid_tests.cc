@@ -0,0 +1,77 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file fixed_mode_pid_tests.cc
+///
+
+#include "../include/FixedModePID.h"
+#include "../include/PID_Controller.h"
+#include <cmath>
+#include <gtest/gtest.h>
+
+template <uint8_t MODE>
+static void compareWithRuntimeMode()
+{
+    double kp = (MODE & DIGITAL_CONTROL::P_BIT) ? 1.2 : 0.0;
+    double ki = (MODE & DIGITAL_CONTROL::I_BIT) ? 0.6 : 0.0;
+    double kd = (MODE & DIGITAL_CONTROL::D_BIT) ? 0.03 : 0.0;
+
+    PID_Controller runtime(kp, ki, kd);
+    runtime.reset();
+    runtime.configureIntegratorSaturation(0.4, -0.4);
+    // Gains for the terms MODE leaves out must have no effect
+    FixedModePID<MODE> fixed(1.2, 0.6, 0.03);
+    fixed.configureIntegratorSaturation(0.4, -0.4);
+
+    for (unsigned int step = 0; step < 1000; step++)
+    {
+        double e = std::sin(0.02 * step) + 0.05 * std::cos(0.9 * step);
+        double uRuntime, uFixed;
+        runtime.update(e, 0.005, &uRuntime);
+        fixed.update(e, 0.005, &uFixed);
+        ASSERT_DOUBLE_EQ(uFixed, uRuntime) << "mode " << (int)MODE << " step " << step;
+    }
+}
+
+TEST(fixed_mode_pid_tests, testMatchesRuntimeModes)
+{
+    compareWithRuntimeMode<DIGITAL_CONTROL::P>();
+    compareWithRuntimeMode<DIGITAL_CONTROL::PI>();
+    compareWithRuntimeMode<DIGITAL_CONTROL::PD>();
+    compareWithRuntimeMode<DIGITAL_CONTROL::PID>();
+}
+
+TEST(fixed_mode_pid_tests, testSaturationAndReset)
+{
+    FixedModePID<DIGITAL_CONTROL::PI, float> pi(1.0f, 1.0f);
+    pi.configureIntegratorSaturation(0.5f, -0.5f);
+    pi.configureOutputSaturation(1.0f, -1.0f);
+
+    float u;
+    for (unsigned int step = 0; step < 30; step++)
+        pi.update(0.2f, 0.1f, &u);
+    // Integral term clamped at 0.5, so 0.2 + 0.5
+    EXPECT_FLOAT_EQ(u, 0.7f);
+    EXPECT_FALSE(pi.outputIsSaturated());
+
+    pi.update(2.0f, 0.1f, &u);
+    EXPECT_FLOAT_EQ(u, 1.0f);
+    EXPECT_TRUE(pi.outputIsSaturated());
+
+    pi.reset();
+    pi.update(0.2f, 0.1f, &u);
+    EXPECT_FLOAT_EQ(u, 0.2f + 0.02f);
+    EXPECT_FALSE(pi.outputIsSaturated());
+}
@@ -0,0 +1,85 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file fixed_point_tests.cc
+///
+
+#include "../include/FixedPoint.h"
+#include "../include/PID_Controller.h"
+#include <cmath>
+#include <gtest/gtest.h>
+
+using DIGITAL_CONTROL::Q16_16;
+
+TEST(fixed_point_tests, testArithmetic)
+{
+    Q16_16 a(1.5), b(-0.25);
+    EXPECT_EQ(a.rawValue(), 0x18000);
+    EXPECT_DOUBLE_EQ((a + b).toDouble(), 1.25);
+    EXPECT_DOUBLE_EQ((a - b).toDouble(), 1.75);
+    EXPECT_DOUBLE_EQ((a * b).toDouble(), -0.375);
+    EXPECT_DOUBLE_EQ((a / b).toDouble(), -6.0);
+    EXPECT_DOUBLE_EQ((-a).toDouble(), -1.5);
+    EXPECT_TRUE(b < a);
+    EXPECT_TRUE(Q16_16(0.0) == Q16_16());
+    // Rounds to the nearest step rather than truncating
+    EXPECT_EQ(Q16_16(0.001).rawValue(), 66);
+    EXPECT_EQ(Q16_16(-0.001).rawValue(), -66);
+}
+
+TEST(fixed_point_tests, testSaturation)
+{
+    Q16_16 big(30000.0);
+    EXPECT_EQ((big + big).rawValue(), Q16_16::RAW_MAX);
+    EXPECT_EQ((-big - big).rawValue(), Q16_16::RAW_MIN);
+    EXPECT_EQ((big * Q16_16(2.0)).rawValue(), Q16_16::RAW_MAX);
+    EXPECT_EQ((big / Q16_16(0.5)).rawValue(), Q16_16::RAW_MAX);
+    EXPECT_EQ((Q16_16(1.0) / Q16_16(0.0)).rawValue(), Q16_16::RAW_MAX);
+    EXPECT_EQ((Q16_16(-1.0) / Q16_16(0.0)).rawValue(), Q16_16::RAW_MIN);
+    EXPECT_EQ(Q16_16(1e9).rawValue(), Q16_16::RAW_MAX);
+    EXPECT_EQ(DIGITAL_CONTROL::upperBound<Q16_16>(), std::numeric_limits<Q16_16>::max());
+    EXPECT_EQ(DIGITAL_CONTROL::lowerBound<float>(), -std::numeric_limits<float>::infinity());
+}
+
+template <typename T>
+static double maxDeviationFromDouble(double tolerance)
+{
+    PID_Controller ref(1.5, 2.0, 0.0);
+    PID_ControllerT<T> pid(T(1.5), T(2.0), T(0.0));
+    ref.reset();
+    pid.reset();
+    ref.configureIntegratorSaturation(1.0, -1.0);
+    pid.configureIntegratorSaturation(T(1.0), T(-1.0));
+
+    double maxDev = 0;
+    for (unsigned int step = 0; step < 1000; step++)
+    {
+        double e = std::sin(0.01 * step);
+        double uRef;
+        T u;
+        ref.update(e, 0.01, &uRef);
+        pid.update(T(e), T(0.01), &u);
+        maxDev = std::fmax(maxDev, std::fabs((double)u - uRef));
+    }
+    EXPECT_LT(maxDev, tolerance);
+    return maxDev;
+}
+
+TEST(fixed_point_tests, testPidScalarTypes)
+{
+    maxDeviationFromDouble<float>(1e-5);
+    // dt = 0.01 is only held to 2^-16, which shows up in the integral
+    maxDeviationFromDouble<Q16_16>(5e-3);
+}
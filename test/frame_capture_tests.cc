@@ -0,0 +1,128 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file frame_capture_tests.cc
+///
+
+#include "../include/FrameCapture.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "vector_sink.h"
+
+using namespace LFAST;
+
+static void recordString(FrameCaptureWriter &writer, uint32_t ts, uint16_t conn, const std::string &frame)
+{
+    writer.record(ts, conn, reinterpret_cast<const uint8_t *>(frame.data()), frame.size());
+}
+
+TEST(frame_capture_tests, testRoundTrip)
+{
+    VectorSink sink;
+    {
+        FrameCaptureWriter writer(sink);
+        recordString(writer, 100, 0, "{\"Handshake\":57005}");
+        recordString(writer, 250, 2, "{\"PMCMessage\":{\"SetTip\":0.01}}");
+        recordString(writer, 0xFFFFFFF0, 1, "");
+        EXPECT_EQ(writer.records(), 3U);
+    }
+
+    FrameCaptureReader reader(sink.bytes.data(), sink.bytes.size());
+    ASSERT_TRUE(reader.valid());
+    CaptureRecord rec;
+    ASSERT_TRUE(reader.next(rec));
+    EXPECT_EQ(rec.timestampUs, 100U);
+    EXPECT_EQ(rec.connectionId, 0);
+    EXPECT_EQ(std::string((const char *)rec.payload, rec.length), "{\"Handshake\":57005}");
+    ASSERT_TRUE(reader.next(rec));
+    EXPECT_EQ(rec.timestampUs, 250U);
+    EXPECT_EQ(rec.connectionId, 2);
+    EXPECT_EQ(std::string((const char *)rec.payload, rec.length), "{\"PMCMessage\":{\"SetTip\":0.01}}");
+    ASSERT_TRUE(reader.next(rec));
+    EXPECT_EQ(rec.timestampUs, 0xFFFFFFF0U);
+    EXPECT_EQ(rec.length, 0);
+    EXPECT_FALSE(reader.next(rec));
+}
+
+TEST(frame_capture_tests, testWholeBlockWrites)
+{
+    VectorSink sink;
+    std::string frame(300, 'x');
+    {
+        FrameCaptureWriter writer(sink);
+        for (uint32_t ii = 0; ii < 10; ii++)
+            recordString(writer, ii, 0, frame);
+    }
+    size_t expectedLen = CAPTURE_FILE_HEADER_SIZE + 10 * (CAPTURE_RECORD_HEADER_SIZE + frame.size());
+    ASSERT_EQ(sink.bytes.size(), expectedLen);
+    // Only the final flush may write a partial block
+    for (size_t ii = 0; ii + 1 < sink.writeSizes.size(); ii++)
+        EXPECT_EQ(sink.writeSizes[ii], (size_t)CAPTURE_BLOCK_SIZE);
+
+    FrameCaptureReader reader(sink.bytes.data(), sink.bytes.size());
+    CaptureRecord rec;
+    uint32_t count = 0;
+    while (reader.next(rec))
+    {
+        EXPECT_EQ(rec.timestampUs, count++);
+        EXPECT_EQ(rec.length, frame.size());
+    }
+    EXPECT_EQ(count, 10U);
+}
+
+TEST(frame_capture_tests, testTruncatedCapture)
+{
+    VectorSink sink;
+    {
+        FrameCaptureWriter writer(sink);
+        recordString(writer, 1, 0, "{\"a\":1}");
+        recordString(writer, 2, 0, "{\"b\":2}");
+    }
+    // Cut the last record short, as a power loss mid-write would
+    sink.bytes.resize(sink.bytes.size() - 3);
+    FrameCaptureReader reader(sink.bytes.data(), sink.bytes.size());
+    CaptureRecord rec;
+    EXPECT_TRUE(reader.next(rec));
+    EXPECT_FALSE(reader.next(rec));
+
+    uint8_t notACapture[16] = {0};
+    FrameCaptureReader badReader(notACapture, sizeof(notACapture));
+    EXPECT_FALSE(badReader.valid());
+    EXPECT_FALSE(badReader.next(rec));
+}
+
+TEST(frame_capture_tests, testFileSink)
+{
+    FILE *file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    {
+        FileCaptureSink sink(file);
+        FrameCaptureWriter writer(sink);
+        recordString(writer, 42, 3, "{\"SetFocus\":1.5}");
+    }
+    std::vector<uint8_t> bytes(CAPTURE_FILE_HEADER_SIZE + CAPTURE_RECORD_HEADER_SIZE + 16);
+    rewind(file);
+    ASSERT_EQ(fread(bytes.data(), 1, bytes.size(), file), bytes.size());
+    fclose(file);
+
+    FrameCaptureReader reader(bytes.data(), bytes.size());
+    CaptureRecord rec;
+    ASSERT_TRUE(reader.next(rec));
+    EXPECT_EQ(rec.timestampUs, 42U);
+    EXPECT_EQ(rec.connectionId, 3);
+    EXPECT_EQ(std::string((const char *)rec.payload, rec.length), "{\"SetFocus\":1.5}");
+}
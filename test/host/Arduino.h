@@ -0,0 +1,94 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file Arduino.h
+/// @brief Host stand-in for the parts of the Arduino core the comms library uses
+///
+/// Only on the include path of host test/replay targets. ARDUINO stays
+/// undefined, so teensy41_device.h still picks HostSerial and the host timers.
+///
+
+#pragma once
+
+#if defined(ARDUINO)
+#error "test/host/Arduino.h is for host builds only"
+#endif
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+
+#include "../../include/HostSerial.h"
+
+typedef uint8_t byte;
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) = 0;
+    virtual size_t write(const uint8_t *buf, size_t size)
+    {
+        size_t n = 0;
+        while (size--)
+            n += write(*buf++);
+        return n;
+    }
+    size_t write(const char *str) { return write((const uint8_t *)str, std::strlen(str)); }
+    virtual void flush() {}
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    size_t readBytes(char *buf, size_t len)
+    {
+        size_t n = 0;
+        while (n < len && available() > 0)
+            buf[n++] = (char)read();
+        return n;
+    }
+};
+
+/// Never connected: host targets add their own Streams as serial links
+class HardwareSerial : public Stream
+{
+public:
+    void begin(uint32_t) {}
+    void transmitterEnable(uint8_t) {}
+    using Print::write;
+    size_t write(uint8_t) override { return 1; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+};
+
+class IPAddress
+{
+public:
+    IPAddress() : octets{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : octets{a, b, c, d} {}
+    uint8_t operator[](int idx) const { return octets[idx]; }
+    uint8_t &operator[](int idx) { return octets[idx]; }
+    bool operator==(const IPAddress &rhs) const { return std::memcmp(octets, rhs.octets, 4) == 0; }
+    bool operator!=(const IPAddress &rhs) const { return !(*this == rhs); }
+
+private:
+    uint8_t octets[4];
+};
@@ -0,0 +1,72 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file Ethernet.h
+/// @brief Host stand-in for the Ethernet library
+///
+/// The PHY always reports present and the TCP server never has a client
+/// waiting; host targets feed TCP traffic in through their own Client.
+///
+
+#pragma once
+
+#include "Arduino.h"
+#include "Client.h"
+
+// i.MX RT fuse registers TcpCommsService reads the MAC address from
+#define HW_OCOTP_MAC0 0x00000000UL
+#define HW_OCOTP_MAC1 0x00000000UL
+
+enum EthernetHardwareStatus
+{
+    EthernetNoHardware,
+    EthernetW5100,
+    EthernetW5200,
+    EthernetW5500
+};
+
+class EthernetClass
+{
+public:
+    int begin(uint8_t *, IPAddress) { return 1; }
+    EthernetHardwareStatus hardwareStatus() { return EthernetW5500; }
+};
+
+inline EthernetClass Ethernet;
+
+class EthernetClient : public Client
+{
+public:
+    int connect(IPAddress, uint16_t) override { return 0; }
+    int connect(const char *, uint16_t) override { return 0; }
+    size_t write(uint8_t) override { return 0; }
+    size_t write(const uint8_t *, size_t) override { return 0; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int read(uint8_t *, size_t) override { return -1; }
+    int peek() override { return -1; }
+    void flush() override {}
+    void stop() override {}
+    uint8_t connected() override { return 0; }
+    operator bool() override { return false; }
+};
+
+class EthernetServer
+{
+public:
+    EthernetServer(uint16_t) {}
+    void begin() {}
+    EthernetClient accept() { return EthernetClient(); }
+};
@@ -0,0 +1,153 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file EthernetUdp.h
+/// @brief Host stand-in for EthernetUDP over a loopback BSD socket
+///
+/// Same calling pattern as the Ethernet library: parsePacket() pulls the next
+/// datagram (without blocking), read() copies it out, and beginPacket() /
+/// write() / endPacket() send one. Only 127.0.0.1 is bound, so tests can
+/// talk to the service from ordinary sockets without leaving the machine.
+///
+
+#pragma once
+
+#include "Arduino.h"
+
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define HOST_UDP_MAX_DATAGRAM 2048
+
+class EthernetUDP : public Print
+{
+public:
+    EthernetUDP() : sock(-1), rxLen(0), rxPos(0), rxPort(0), txPort(0) {}
+    virtual ~EthernetUDP() { stop(); }
+
+    /// @param port Local port; 0 picks a free one (see localPort())
+    /// @return 1 on success
+    uint8_t begin(uint16_t port)
+    {
+        stop();
+        sock = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (sock < 0)
+            return 0;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        if (::bind(sock, (sockaddr *)&addr, sizeof(addr)) != 0)
+        {
+            stop();
+            return 0;
+        }
+        return 1;
+    }
+
+    void stop()
+    {
+        if (sock >= 0)
+            ::close(sock);
+        sock = -1;
+    }
+
+    uint16_t localPort()
+    {
+        sockaddr_in addr{};
+        socklen_t addrLen = sizeof(addr);
+        if (sock < 0 || ::getsockname(sock, (sockaddr *)&addr, &addrLen) != 0)
+            return 0;
+        return ntohs(addr.sin_port);
+    }
+
+    /// @return size of the next datagram, or 0 if none is waiting
+    int parsePacket()
+    {
+        rxLen = rxPos = 0;
+        if (sock < 0)
+            return 0;
+        sockaddr_in from{};
+        socklen_t fromLen = sizeof(from);
+        ssize_t n = ::recvfrom(sock, rxBuff, sizeof(rxBuff), MSG_DONTWAIT, (sockaddr *)&from, &fromLen);
+        if (n <= 0)
+            return 0;
+        rxLen = (size_t)n;
+        uint32_t addr = ntohl(from.sin_addr.s_addr);
+        rxIp = IPAddress(addr >> 24, addr >> 16, addr >> 8, addr);
+        rxPort = ntohs(from.sin_port);
+        return (int)n;
+    }
+
+    int read(unsigned char *buf, size_t len)
+    {
+        size_t n = rxLen - rxPos;
+        if (n > len)
+            n = len;
+        std::memcpy(buf, rxBuff + rxPos, n);
+        rxPos += n;
+        return (int)n;
+    }
+
+    IPAddress remoteIP() { return rxIp; }
+    uint16_t remotePort() { return rxPort; }
+
+    int beginPacket(IPAddress ip, uint16_t port)
+    {
+        txIp = ip;
+        txPort = port;
+        txBuff.clear();
+        return 1;
+    }
+
+    using Print::write;
+    size_t write(uint8_t b) override
+    {
+        txBuff.push_back(b);
+        return 1;
+    }
+    size_t write(const uint8_t *buf, size_t size) override
+    {
+        txBuff.insert(txBuff.end(), buf, buf + size);
+        return size;
+    }
+
+    int endPacket()
+    {
+        if (sock < 0)
+            return 0;
+        sockaddr_in to{};
+        to.sin_family = AF_INET;
+        to.sin_addr.s_addr = htonl(((uint32_t)txIp[0] << 24) | ((uint32_t)txIp[1] << 16) | ((uint32_t)txIp[2] << 8) | txIp[3]);
+        to.sin_port = htons(txPort);
+        ssize_t n = ::sendto(sock, txBuff.data(), txBuff.size(), 0, (sockaddr *)&to, sizeof(to));
+        return (n == (ssize_t)txBuff.size()) ? 1 : 0;
+    }
+
+private:
+    int sock;
+    uint8_t rxBuff[HOST_UDP_MAX_DATAGRAM];
+    size_t rxLen;
+    size_t rxPos;
+    IPAddress rxIp;
+    uint16_t rxPort;
+    IPAddress txIp;
+    uint16_t txPort;
+    std::vector<uint8_t> txBuff;
+};
@@ -0,0 +1,60 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file StreamUtils.h
+/// @brief Host stand-in for StreamUtils' WriteBufferingStream
+///
+
+#pragma once
+
+#include "Arduino.h"
+
+#include <vector>
+
+class WriteBufferingStream : public Print
+{
+public:
+    WriteBufferingStream(Print &_upstream, size_t _capacity) : upstream(_upstream), capacity(_capacity ? _capacity : 1)
+    {
+        buff.reserve(capacity);
+    }
+    ~WriteBufferingStream() { flush(); }
+
+    using Print::write;
+    size_t write(uint8_t b) override
+    {
+        buff.push_back(b);
+        if (buff.size() >= capacity)
+            flush();
+        return 1;
+    }
+    size_t write(const uint8_t *buf, size_t size) override
+    {
+        for (size_t ii = 0; ii < size; ii++)
+            write(buf[ii]);
+        return size;
+    }
+    void flush() override
+    {
+        if (!buff.empty())
+            upstream.write(buff.data(), buff.size());
+        buff.clear();
+    }
+
+private:
+    Print &upstream;
+    size_t capacity;
+    std::vector<uint8_t> buff;
+};
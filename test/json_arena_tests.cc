@@ -0,0 +1,110 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file json_arena_tests.cc
+///
+
+#include "../include/JsonArena.h"
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+
+using LFAST::JsonArena;
+
+TEST(json_arena_tests, testResetOnlyWhenNothingLive)
+{
+    ASSERT_TRUE(JsonArena::reset());
+    void *a = JsonArena::allocate(100);
+    void *b = JsonArena::allocate(20);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(JsonArena::liveAllocations(), 2u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 8, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 8, 0u);
+
+    JsonArena::deallocate(a);
+    EXPECT_FALSE(JsonArena::reset());
+    JsonArena::deallocate(b);
+    EXPECT_TRUE(JsonArena::reset());
+    EXPECT_EQ(JsonArena::bytesUsed(), 0u);
+    EXPECT_GT(JsonArena::highWaterMark(), 120u);
+
+    // Same tick pattern again lands in the same place
+    void *a2 = JsonArena::allocate(100);
+    EXPECT_EQ(a2, a);
+    JsonArena::deallocate(a2);
+    JsonArena::reset();
+}
+
+TEST(json_arena_tests, testReallocateNewestInPlace)
+{
+    ASSERT_TRUE(JsonArena::reset());
+    char *p = static_cast<char *>(JsonArena::allocate(16));
+    std::strcpy(p, "setpoint");
+    char *q = static_cast<char *>(JsonArena::reallocate(p, 64));
+    EXPECT_EQ(p, q);
+    EXPECT_STREQ(q, "setpoint");
+
+    // Not the newest any more, so growing has to move it
+    void *other = JsonArena::allocate(8);
+    char *r = static_cast<char *>(JsonArena::reallocate(q, 128));
+    EXPECT_NE(r, q);
+    EXPECT_STREQ(r, "setpoint");
+
+    JsonArena::deallocate(other);
+    JsonArena::deallocate(r);
+    EXPECT_TRUE(JsonArena::reset());
+}
+
+TEST(json_arena_tests, testFallbackWhenFull)
+{
+    ASSERT_TRUE(JsonArena::reset());
+    unsigned int fallbacksBefore = JsonArena::fallbackAllocations();
+    void *big = JsonArena::allocate(JSON_ARENA_SIZE - 64);
+    void *overflow = JsonArena::allocate(256);
+    ASSERT_NE(overflow, nullptr);
+    EXPECT_EQ(JsonArena::fallbackAllocations(), fallbacksBefore + 1);
+    std::memset(overflow, 0xA5, 256);
+
+    JsonArena::deallocate(overflow);
+    JsonArena::deallocate(big);
+    EXPECT_TRUE(JsonArena::reset());
+}
+
+TEST(json_arena_tests, testLongLivedBlockOnlyPinsItself)
+{
+    ASSERT_TRUE(JsonArena::reset());
+    void *tick = JsonArena::allocate(200);
+    void *kept = JsonArena::allocate(40);
+    JsonArena::deallocate(tick);
+    EXPECT_FALSE(JsonArena::reset());
+    size_t pinned = JsonArena::bytesUsed();
+
+    // Later ticks reuse the space after the kept block rather than growing the arena
+    for (int ii = 0; ii < 100; ii++)
+    {
+        void *msg = JsonArena::allocate(300);
+        void *doc = JsonArena::allocate(500);
+        JsonArena::deallocate(doc);
+        JsonArena::deallocate(msg);
+        EXPECT_FALSE(JsonArena::reset());
+        EXPECT_EQ(JsonArena::bytesUsed(), pinned);
+    }
+    EXPECT_LT(JsonArena::highWaterMark(), (size_t)JSON_ARENA_SIZE);
+
+    JsonArena::deallocate(kept);
+    EXPECT_TRUE(JsonArena::reset());
+    EXPECT_EQ(JsonArena::bytesUsed(), 0u);
+}
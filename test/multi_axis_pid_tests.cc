@@ -0,0 +1,125 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file multi_axis_pid_tests.cc
+///
+
+#include "../include/MultiAxisPID.h"
+#include "../include/PID_Controller.h"
+#include <cmath>
+#include <gtest/gtest.h>
+
+#define NUM_TEST_AXES 6
+
+// P, PI, PD, PID, I and D only, so every compensation mode gets compared
+static const double testGains[NUM_TEST_AXES][3] = {
+    {2.0, 0.0, 0.0},
+    {1.5, 0.4, 0.0},
+    {0.8, 0.0, 0.05},
+    {1.2, 0.3, 0.02},
+    {0.0, 0.7, 0.0},
+    {0.0, 0.0, 0.1}};
+
+static double testError(unsigned int axis, unsigned int step)
+{
+    return std::sin(0.01 * step * (axis + 1)) + 0.1 * std::cos(0.37 * step);
+}
+
+TEST(multi_axis_pid_tests, testMatchesScalar)
+{
+    PID_Controller scalar[NUM_TEST_AXES];
+    MultiAxisPID<NUM_TEST_AXES> batch;
+    for (unsigned int ax = 0; ax < NUM_TEST_AXES; ax++)
+    {
+        scalar[ax].configureGains(testGains[ax][0], testGains[ax][1], testGains[ax][2]);
+        scalar[ax].reset();
+        batch.configureGains(ax, testGains[ax][0], testGains[ax][1], testGains[ax][2]);
+    }
+    scalar[3].configureIntegratorSaturation(0.5, -0.5);
+    batch.configureIntegratorSaturation(3, 0.5, -0.5);
+
+    const double dt = 0.001;
+    double e[NUM_TEST_AXES], u[NUM_TEST_AXES];
+    for (unsigned int step = 0; step < 2000; step++)
+    {
+        for (unsigned int ax = 0; ax < NUM_TEST_AXES; ax++)
+            e[ax] = testError(ax, step);
+        batch.update(e, dt, u);
+        for (unsigned int ax = 0; ax < NUM_TEST_AXES; ax++)
+        {
+            double uScalar;
+            scalar[ax].update(e[ax], dt, &uScalar);
+            // The batch multiplies by 1/dt rather than dividing, so allow for rounding
+            ASSERT_NEAR(u[ax], uScalar, 1e-9 * (1.0 + std::fabs(uScalar))) << "axis " << ax << " step " << step;
+        }
+    }
+}
+
+TEST(multi_axis_pid_tests, testOutputSaturation)
+{
+    MultiAxisPID<2> batch;
+    batch.configureGains(0, 10.0, 0.0, 0.0);
+    batch.configureGains(1, 10.0, 0.0, 0.0);
+    batch.configureOutputSaturation(0, 1.0, -1.0);
+
+    double e[2] = {0.5, 0.5};
+    double u[2];
+    batch.update(e, 0.01, u);
+    EXPECT_DOUBLE_EQ(u[0], 1.0);
+    EXPECT_TRUE(batch.outputIsSaturated(0));
+    EXPECT_DOUBLE_EQ(u[1], 5.0);
+    EXPECT_FALSE(batch.outputIsSaturated(1));
+
+    e[0] = 0.05;
+    batch.update(e, 0.01, u);
+    EXPECT_DOUBLE_EQ(u[0], 0.5);
+    EXPECT_FALSE(batch.outputIsSaturated(0));
+}
+
+TEST(multi_axis_pid_tests, testReset)
+{
+    MultiAxisPID<1> batch;
+    batch.configureGains(0, 0.0, 1.0, 1.0);
+    double e = 1.0, u;
+    batch.update(&e, 0.1, &u);
+    // No derivative on the first step
+    EXPECT_DOUBLE_EQ(u, 0.1);
+    batch.update(&e, 0.1, &u);
+    EXPECT_DOUBLE_EQ(u, 0.2);
+
+    batch.reset();
+    e = 2.0;
+    batch.update(&e, 0.1, &u);
+    EXPECT_DOUBLE_EQ(u, 0.2);
+}
+
+TEST(multi_axis_pid_tests, testZeroTimeStep)
+{
+    MultiAxisPID<2> batch;
+    batch.configureGains(0, 2.0, 0.0, 0.0);
+    batch.configureGains(1, 1.0, 1.0, 1.0);
+    double e[2] = {1.0, 1.0}, u[2];
+    batch.update(e, 0.1, u);
+    EXPECT_DOUBLE_EQ(u[1], 1.1);
+
+    // Only the proportional term acts, and the integrator holds its value
+    e[0] = e[1] = 3.0;
+    batch.update(e, 0.0, u);
+    EXPECT_DOUBLE_EQ(u[0], 6.0);
+    EXPECT_DOUBLE_EQ(u[1], 3.1);
+    batch.update(e, -0.1, u);
+    EXPECT_DOUBLE_EQ(u[0], 6.0);
+    EXPECT_DOUBLE_EQ(u[1], 3.1);
+}
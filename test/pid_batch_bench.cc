@@ -0,0 +1,149 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file pid_batch_bench.cc
+///
+/// Cost of updating N PID loops per control tick: N separate
+/// PID_Controller::update() calls vs one MultiAxisPID<N>::update(). Reports
+/// ns per tick and per axis for a few axis counts. Configure the test build
+/// with -DCMAKE_BUILD_TYPE=Release; unoptimized numbers mean nothing here.
+///
+/// Host:   ./pid_batch_bench [numTicks]
+/// Teensy: add this file to a PlatformIO project with the library; results
+///         are printed to Serial once at startup.
+
+#include "../include/MultiAxisPID.h"
+#include "../include/PID_Controller.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#define BENCH_DEFAULT_TICKS 20000
+#define BENCH_PRINTF Serial.printf
+static double benchNowNs() { return micros() * 1000.0; }
+#else
+#include <chrono>
+#define BENCH_DEFAULT_TICKS 200000
+#define BENCH_PRINTF std::printf
+static double benchNowNs()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+// Precomputed so only the controller updates are timed
+#define BENCH_ERROR_STEPS 64
+
+struct Result
+{
+    double scalarNs;
+    double batchNs;
+    double maxDiff;
+};
+
+static void gainsFor(unsigned int axis, double *kp, double *ki, double *kd)
+{
+    *kp = 1.0 + 0.1 * axis;
+    *ki = 0.2 + 0.01 * axis;
+    *kd = 0.01 * (axis % 3);
+}
+
+template <unsigned int N>
+static Result runBench(unsigned int numTicks)
+{
+    static double errors[BENCH_ERROR_STEPS][N];
+    for (unsigned int step = 0; step < BENCH_ERROR_STEPS; step++)
+        for (unsigned int ax = 0; ax < N; ax++)
+            errors[step][ax] = std::sin(0.1 * step + ax);
+
+    static PID_Controller scalar[N];
+    static MultiAxisPID<N> batch;
+    for (unsigned int ax = 0; ax < N; ax++)
+    {
+        double kp, ki, kd;
+        gainsFor(ax, &kp, &ki, &kd);
+        scalar[ax].configureGains(kp, ki, kd);
+        scalar[ax].configureIntegratorSaturation(10.0, -10.0);
+        scalar[ax].reset();
+        batch.configureGains(ax, kp, ki, kd);
+        batch.configureIntegratorSaturation(ax, 10.0, -10.0);
+    }
+    batch.reset();
+
+    const double dt = 0.001;
+    double uScalar[N], uBatch[N];
+
+    double start = benchNowNs();
+    for (unsigned int tick = 0; tick < numTicks; tick++)
+    {
+        const double *e = errors[tick % BENCH_ERROR_STEPS];
+        for (unsigned int ax = 0; ax < N; ax++)
+            scalar[ax].update(e[ax], dt, &uScalar[ax]);
+    }
+    double scalarNs = benchNowNs() - start;
+
+    start = benchNowNs();
+    for (unsigned int tick = 0; tick < numTicks; tick++)
+        batch.update(errors[tick % BENCH_ERROR_STEPS], dt, uBatch);
+    double batchNs = benchNowNs() - start;
+
+    // Both ran the same error sequence, so the last outputs should agree
+    double maxDiff = 0;
+    for (unsigned int ax = 0; ax < N; ax++)
+        maxDiff = std::fmax(maxDiff, std::fabs(uScalar[ax] - uBatch[ax]));
+
+    return {scalarNs / numTicks, batchNs / numTicks, maxDiff};
+}
+
+template <unsigned int N>
+static void report(unsigned int numTicks)
+{
+    Result r = runBench<N>(numTicks);
+    BENCH_PRINTF("%5u %12.1f %12.1f %10.2f %10.2f %8.2fx %10.2e\n", N, r.scalarNs, r.batchNs,
+                 r.scalarNs / N, r.batchNs / N, r.scalarNs / r.batchNs, r.maxDiff);
+}
+
+static void runAll(unsigned int numTicks)
+{
+    BENCH_PRINTF("%u ticks\n", numTicks);
+    BENCH_PRINTF("%5s %12s %12s %10s %10s %9s %10s\n", "axes", "scalar ns", "batch ns",
+                 "scalar/ax", "batch/ax", "speedup", "max diff");
+    report<1>(numTicks);
+    report<4>(numTicks);
+    report<12>(numTicks);
+    report<32>(numTicks);
+}
+
+#if defined(ARDUINO)
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial && millis() < 3000)
+        ;
+    runAll(BENCH_DEFAULT_TICKS);
+}
+
+void loop() {}
+#else
+int main(int argc, char **argv)
+{
+    unsigned int numTicks = (argc > 1) ? std::atoi(argv[1]) : BENCH_DEFAULT_TICKS;
+    runAll(numTicks);
+    return 0;
+}
+#endif
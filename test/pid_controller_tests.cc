@@ -0,0 +1,120 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file pid_controller_tests.cc
+///
+
+#include "../include/PID_Controller.h"
+#include "../include/df2_filter.h"
+#include <cmath>
+#include <gtest/gtest.h>
+
+TEST(pid_controller_tests, testStaticFilterMatchesDynamic)
+{
+    DF2_IIR<double> dynamicFilter(DIGITAL_CONTROL::lpf_10_b, DIGITAL_CONTROL::lpf_10_a, 2);
+    StaticDF2_IIR<double, 2> staticFilter(DIGITAL_CONTROL::lpf_10_b, DIGITAL_CONTROL::lpf_10_a);
+    for (unsigned int step = 0; step < 500; step++)
+    {
+        double x = std::sin(0.3 * step) + ((step % 17) == 0 ? 1.0 : 0.0);
+        ASSERT_DOUBLE_EQ(staticFilter.update(x), dynamicFilter.update(x)) << "step " << step;
+    }
+
+    const double badPoles[] = {2.0, 0.0, 0.0};
+    EXPECT_FALSE(staticFilter.configure(DIGITAL_CONTROL::lpf_10_b, badPoles));
+    EXPECT_TRUE(staticFilter.configure(DIGITAL_CONTROL::lpf_10_b, DIGITAL_CONTROL::lpf_10_a));
+}
+
+TEST(pid_controller_tests, testInitialState)
+{
+    // No reset() call: the integrator and derivative must still start clean
+    PID_Controller pid(0.0, 1.0, 1.0);
+    double u;
+    pid.update(1.0, 0.1, &u);
+    EXPECT_DOUBLE_EQ(u, 0.1);
+    EXPECT_FALSE(pid.outputIsSaturated());
+}
+
+TEST(pid_controller_tests, testFilteredDerivative)
+{
+    // bldiff_30 is a differentiator for a 100 Hz loop
+    const double dt = 0.01;
+    PID_Controller pid(0.0, 0.0, 1.0);
+    pid.configureDerivativeFilter(DIGITAL_CONTROL::bldiff_30_b, DIGITAL_CONTROL::bldiff_30_a);
+    StaticDF2_IIR<double, PID_DERIVATIVE_FILTER_ORDER> reference(DIGITAL_CONTROL::bldiff_30_b, DIGITAL_CONTROL::bldiff_30_a);
+
+    double u = 0;
+    for (unsigned int step = 0; step < 200; step++)
+    {
+        double e = 3.0 * step * dt;
+        pid.update(e, dt, &u);
+        ASSERT_DOUBLE_EQ(u, reference.update(e));
+    }
+    // Settles on the ramp's slope (the table's DC gain is 100 to about 1e-5)
+    EXPECT_NEAR(u, 3.0, 1e-4);
+
+    pid.disableDerivativeFilter();
+    pid.update(3.0 * 200 * dt, dt, &u);
+    EXPECT_NEAR(u, 3.0, 1e-9);
+
+    // Bad poles are refused and the raw difference stays in use
+    const double badPoles[] = {0.5, 0.0, 0.0};
+    pid.configureDerivativeFilter(DIGITAL_CONTROL::bldiff_30_b, badPoles);
+    pid.update(3.0 * 201 * dt, dt, &u);
+    EXPECT_NEAR(u, 3.0, 1e-9);
+}
+
+TEST(pid_controller_tests, testOutputSaturation)
+{
+    PID_ControllerF pid(10.0f, 0.0f, 0.0f);
+    pid.configureOutputSaturation(1.0f, -2.0f);
+    float u;
+    pid.update(0.05f, 0.01f, &u);
+    EXPECT_FLOAT_EQ(u, 0.5f);
+    EXPECT_FALSE(pid.outputIsSaturated());
+    pid.update(0.5f, 0.01f, &u);
+    EXPECT_FLOAT_EQ(u, 1.0f);
+    EXPECT_TRUE(pid.outputIsSaturated());
+    pid.update(-0.5f, 0.01f, &u);
+    EXPECT_FLOAT_EQ(u, -2.0f);
+    EXPECT_TRUE(pid.outputIsSaturated());
+}
+
+/// @brief Steps until the output comes off its upper limit after the error changes sign
+static unsigned int recoverySteps(double kb)
+{
+    PID_Controller pid(1.0, 5.0, 0.0);
+    pid.configureOutputSaturation(1.0, -1.0);
+    pid.configureAntiWindup(kb);
+    double u;
+    for (unsigned int step = 0; step < 500; step++)
+        pid.update(2.0, 0.01, &u);
+    EXPECT_TRUE(pid.outputIsSaturated());
+
+    unsigned int steps = 0;
+    do
+    {
+        pid.update(-0.2, 0.01, &u);
+        steps++;
+    } while (u >= 1.0 && steps < 10000);
+    return steps;
+}
+
+TEST(pid_controller_tests, testBackCalculationAntiWindup)
+{
+    unsigned int withoutAntiWindup = recoverySteps(0.0);
+    unsigned int withAntiWindup = recoverySteps(5.0);
+    EXPECT_GT(withoutAntiWindup, 400U);
+    EXPECT_LT(withAntiWindup, 50U);
+}
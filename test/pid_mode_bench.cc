@@ -0,0 +1,117 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file pid_mode_bench.cc
+///
+/// ns per update() for each compensation mode: PID_Controller, which picks
+/// the mode at runtime from its gains, vs FixedModePID<MODE>. Configure the
+/// test build with -DCMAKE_BUILD_TYPE=Release.
+///
+/// Host:   ./pid_mode_bench [numUpdates]
+/// Teensy: add this file to a PlatformIO project with the library; results
+///         are printed to Serial once at startup.
+
+#include "../include/FixedModePID.h"
+#include "../include/PID_Controller.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#define BENCH_DEFAULT_UPDATES 100000
+#define BENCH_PRINTF Serial.printf
+static double benchNowNs() { return micros() * 1000.0; }
+#else
+#include <chrono>
+#define BENCH_DEFAULT_UPDATES 5000000
+#define BENCH_PRINTF std::printf
+static double benchNowNs()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+#define BENCH_ERROR_STEPS 256
+
+static double errors[BENCH_ERROR_STEPS];
+
+template <typename Controller>
+static double timeUpdates(Controller &pid, unsigned int numUpdates, double *checksum)
+{
+    double u, sum = 0;
+    double start = benchNowNs();
+    for (unsigned int ii = 0; ii < numUpdates; ii++)
+    {
+        pid.update(errors[ii % BENCH_ERROR_STEPS], 0.001, &u);
+        sum += u;
+    }
+    double elapsed = benchNowNs() - start;
+    *checksum = sum;
+    return elapsed / numUpdates;
+}
+
+template <uint8_t MODE>
+static void report(const char *name, unsigned int numUpdates)
+{
+    double kp = (MODE & DIGITAL_CONTROL::P_BIT) ? 1.5 : 0.0;
+    double ki = (MODE & DIGITAL_CONTROL::I_BIT) ? 4.0 : 0.0;
+    double kd = (MODE & DIGITAL_CONTROL::D_BIT) ? 0.02 : 0.0;
+
+    PID_Controller runtime(kp, ki, kd);
+    runtime.configureIntegratorSaturation(5.0, -5.0);
+    runtime.reset();
+    FixedModePID<MODE> fixed(kp, ki, kd);
+    fixed.configureIntegratorSaturation(5.0, -5.0);
+
+    double runtimeSum, fixedSum;
+    double runtimeNs = timeUpdates(runtime, numUpdates, &runtimeSum);
+    double fixedNs = timeUpdates(fixed, numUpdates, &fixedSum);
+    BENCH_PRINTF("%-5s %12.2f %12.2f %9.2fx %s\n", name, runtimeNs, fixedNs, runtimeNs / fixedNs,
+                 (runtimeSum == fixedSum) ? "" : "(outputs differ)");
+}
+
+static void runAll(unsigned int numUpdates)
+{
+    for (unsigned int ii = 0; ii < BENCH_ERROR_STEPS; ii++)
+        errors[ii] = 0.5 * std::sin(0.05 * ii);
+
+    BENCH_PRINTF("%u updates\n", numUpdates);
+    BENCH_PRINTF("%-5s %12s %12s %10s\n", "mode", "runtime ns", "fixed ns", "speedup");
+    report<DIGITAL_CONTROL::P>("P", numUpdates);
+    report<DIGITAL_CONTROL::PI>("PI", numUpdates);
+    report<DIGITAL_CONTROL::PD>("PD", numUpdates);
+    report<DIGITAL_CONTROL::PID>("PID", numUpdates);
+}
+
+#if defined(ARDUINO)
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial && millis() < 3000)
+        ;
+    runAll(BENCH_DEFAULT_UPDATES);
+}
+
+void loop() {}
+#else
+int main(int argc, char **argv)
+{
+    unsigned int numUpdates = (argc > 1) ? std::atoi(argv[1]) : BENCH_DEFAULT_UPDATES;
+    runAll(numUpdates);
+    return 0;
+}
+#endif
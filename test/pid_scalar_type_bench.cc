@@ -0,0 +1,157 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file pid_scalar_type_bench.cc
+///
+/// Accuracy vs speed of PID_ControllerT for double, float and Q16.16.
+///  - Speed: ns per update() over a precomputed error sequence.
+///  - Accuracy: each controller closes the loop around the same first order
+///    plant (simulated in double) tracking a setpoint profile; reports the
+///    largest and RMS difference in plant output from the double controller.
+/// Configure the test build with -DCMAKE_BUILD_TYPE=Release.
+///
+/// Host:   ./pid_scalar_type_bench [numUpdates]
+/// Teensy: add this file to a PlatformIO project with the library; results
+///         are printed to Serial once at startup.
+
+#include "../include/PID_Controller.h"
+#include "../include/FixedPoint.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#define BENCH_DEFAULT_UPDATES 100000
+#define BENCH_PRINTF Serial.printf
+static double benchNowNs() { return micros() * 1000.0; }
+#else
+#include <chrono>
+#define BENCH_DEFAULT_UPDATES 2000000
+#define BENCH_PRINTF std::printf
+static double benchNowNs()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+#define BENCH_ERROR_STEPS 256
+#define BENCH_SIM_STEPS 5000
+
+static const double benchKp = 2.0;
+static const double benchKi = 20.0;
+static const double benchKd = 0.01;
+static const double benchDt = 0.001;
+static const double plantTau = 0.05;
+
+static double setpointAt(unsigned int step)
+{
+    // A step, then a slow sine
+    return (step < BENCH_SIM_STEPS / 2) ? 1.0 : 1.0 + 0.5 * std::sin(0.005 * step);
+}
+
+template <typename T>
+static double timeUpdates(unsigned int numUpdates)
+{
+    static T errors[BENCH_ERROR_STEPS];
+    for (unsigned int ii = 0; ii < BENCH_ERROR_STEPS; ii++)
+        errors[ii] = T(0.5 * std::sin(0.05 * ii));
+
+    PID_ControllerT<T> pid{T(benchKp), T(benchKi), T(benchKd)};
+    pid.configureIntegratorSaturation(T(5.0), T(-5.0));
+    pid.reset();
+    T u;
+    T dt(benchDt);
+    double sum = 0;
+
+    double start = benchNowNs();
+    for (unsigned int ii = 0; ii < numUpdates; ii++)
+    {
+        pid.update(errors[ii % BENCH_ERROR_STEPS], dt, &u);
+        if ((ii % BENCH_ERROR_STEPS) == 0)
+            sum += (double)u;
+    }
+    double elapsed = benchNowNs() - start;
+    // Keeps the loop from being optimized away
+    if (std::isnan(sum))
+        BENCH_PRINTF("nan\n");
+    return elapsed / numUpdates;
+}
+
+template <typename T>
+static void simulate(double *plantOut)
+{
+    PID_ControllerT<T> pid{T(benchKp), T(benchKi), T(benchKd)};
+    pid.configureIntegratorSaturation(T(5.0), T(-5.0));
+    pid.reset();
+    T dt(benchDt);
+    double x = 0;
+    for (unsigned int step = 0; step < BENCH_SIM_STEPS; step++)
+    {
+        T u;
+        pid.update(T(setpointAt(step) - x), dt, &u);
+        x += ((double)u - x) * (benchDt / plantTau);
+        plantOut[step] = x;
+    }
+}
+
+template <typename T>
+static void report(const char *name, unsigned int numUpdates, const double *reference, double refNs)
+{
+    static double plantOut[BENCH_SIM_STEPS];
+    simulate<T>(plantOut);
+    double maxErr = 0, sumSq = 0;
+    for (unsigned int step = 0; step < BENCH_SIM_STEPS; step++)
+    {
+        double err = std::fabs(plantOut[step] - reference[step]);
+        maxErr = std::fmax(maxErr, err);
+        sumSq += err * err;
+    }
+    double ns = timeUpdates<T>(numUpdates);
+    BENCH_PRINTF("%-8s %10.2f %9.2fx %12.3e %12.3e\n", name, ns, refNs / ns, maxErr, std::sqrt(sumSq / BENCH_SIM_STEPS));
+}
+
+static void runAll(unsigned int numUpdates)
+{
+    static double reference[BENCH_SIM_STEPS];
+    simulate<double>(reference);
+    double refNs = timeUpdates<double>(numUpdates);
+
+    BENCH_PRINTF("%u updates, %u closed loop steps\n", numUpdates, BENCH_SIM_STEPS);
+    BENCH_PRINTF("%-8s %10s %10s %12s %12s\n", "type", "ns/update", "vs double", "max err", "rms err");
+    report<double>("double", numUpdates, reference, refNs);
+    report<float>("float", numUpdates, reference, refNs);
+    report<DIGITAL_CONTROL::Q16_16>("Q16.16", numUpdates, reference, refNs);
+}
+
+#if defined(ARDUINO)
+void setup()
+{
+    Serial.begin(115200);
+    while (!Serial && millis() < 3000)
+        ;
+    runAll(BENCH_DEFAULT_UPDATES);
+}
+
+void loop() {}
+#else
+int main(int argc, char **argv)
+{
+    unsigned int numUpdates = (argc > 1) ? std::atoi(argv[1]) : BENCH_DEFAULT_UPDATES;
+    runAll(numUpdates);
+    return 0;
+}
+#endif
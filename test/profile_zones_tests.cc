@@ -0,0 +1,72 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file profile_zones_tests.cc
+///
+
+
+#include "../include/ProfileZones.h"
+#include <chrono>
+#include <thread>
+#include <gtest/gtest.h>
+
+using namespace LFAST;
+
+static void timedWork(int sleepUs)
+{
+    PROFILE_ZONE("timedWork");
+    std::this_thread::sleep_for(std::chrono::microseconds(sleepUs));
+}
+
+TEST(profile_zones_tests, testZoneStats)
+{
+    timedWork(200);
+    timedWork(2000);
+    ProfileZone *zone = ProfileZones::zone("timedWork");
+    ASSERT_NE(zone, nullptr);
+    EXPECT_EQ(zone->count, 2U);
+    EXPECT_GE(zone->minUs, 200U);
+    EXPECT_GE(zone->maxUs, 2000U);
+    EXPECT_LE(zone->minUs, zone->meanUs());
+    EXPECT_LE(zone->meanUs(), zone->maxUs);
+
+    ProfileZones::resetAll();
+    EXPECT_EQ(zone->count, 0U);
+    EXPECT_EQ(zone->meanUs(), 0U);
+}
+
+TEST(profile_zones_tests, testSameNameSameZone)
+{
+    ProfileZone *first = ProfileZones::zone("shared");
+    EXPECT_EQ(ProfileZones::zone("shared"), first);
+    EXPECT_NE(ProfileZones::zone("other"), first);
+}
+
+TEST(profile_zones_tests, testFullTable)
+{
+    static char names[MAX_PROFILE_ZONES + 1][16];
+    for (size_t ii = 0; ii <= MAX_PROFILE_ZONES; ii++)
+        snprintf(names[ii], sizeof(names[ii]), "zone%zu", ii);
+    size_t added = 0;
+    for (size_t ii = 0; ii <= MAX_PROFILE_ZONES; ii++)
+    {
+        if (ProfileZones::zone(names[ii]) != nullptr)
+            added++;
+    }
+    EXPECT_EQ(ProfileZones::count(), (size_t)MAX_PROFILE_ZONES);
+    EXPECT_LT(added, (size_t)MAX_PROFILE_ZONES + 1);
+    // A zone that didn't fit is simply not timed
+    ProfileScope scope(nullptr);
+}
@@ -0,0 +1,228 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file serial_framing_bench.cc
+///
+/// Throughput benchmark for the serial transport, run over a Linux
+/// pseudo-terminal pair so no hardware is needed. A writer thread pushes COBS
+/// framed JSON messages into the master side. The slave side is read two ways:
+///
+///   decoder  bulk reads straight into a CobsFrameDecoder, as a baseline for
+///            the framing alone
+///   service  the slave fd is a Stream added with addSerialLink(), so reads go
+///            through StreamClient and SerialCommsService, and every frame is
+///            parsed and dispatched to (counting) PMCMessage handlers by the
+///            usual checkForNewClientData()/processClientData() loop
+///
+/// ./serial_framing_bench [numFrames]
+
+#include "../include/SerialCommsService.h"
+#include "../include/cobs_framing.h"
+
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char *sampleMsg = "{\"PMCMessage\":{\"SetTip\":0.0349,\"SetTilt\":0.0523,\"SetFocus\":10.0,\"MoveType\":1}}";
+#define HANDLERS_PER_MSG 4
+
+/// @brief Stream over a tty fd, buffered like a UART's receive ring
+class PtyStream : public Stream
+{
+public:
+    PtyStream(int _fd) : fd(_fd) {}
+
+    int available() override
+    {
+        int pending = 0;
+        ioctl(fd, FIONREAD, &pending);
+        return (int)(rxLen - rxPos) + pending;
+    }
+    int read() override
+    {
+        if (rxPos >= rxLen && !refill())
+            return -1;
+        return rx[rxPos++];
+    }
+    int peek() override
+    {
+        if (rxPos >= rxLen && !refill())
+            return -1;
+        return rx[rxPos];
+    }
+    using Print::write;
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *buf, size_t size) override
+    {
+        ssize_t n = ::write(fd, buf, size);
+        return n > 0 ? (size_t)n : 0;
+    }
+
+private:
+    bool refill()
+    {
+        ssize_t n = ::read(fd, rx, sizeof(rx));
+        rxPos = 0;
+        rxLen = n > 0 ? (size_t)n : 0;
+        return rxLen > 0;
+    }
+
+    int fd;
+    uint8_t rx[1024];
+    size_t rxPos = 0;
+    size_t rxLen = 0;
+};
+
+class BenchService : public LFAST::SerialCommsService
+{
+public:
+    const LFAST::CommsLinkStats &totals() { return commsStats.totals; }
+};
+
+static unsigned long handlerCalls = 0;
+static void countDouble(double) { handlerCalls++; }
+static void countInt(int) { handlerCalls++; }
+
+static void makeRaw(int fd)
+{
+    termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(fd, TCSANOW, &tio);
+}
+
+/// @brief Opens a raw pty pair and starts a thread writing numFrames copies of frame to the master
+static std::thread startWriter(int *master, int *slave, const std::vector<uint8_t> &frame, unsigned int numFrames)
+{
+    if (openpty(master, slave, nullptr, nullptr, nullptr) != 0)
+    {
+        perror("openpty");
+        std::exit(1);
+    }
+    makeRaw(*master);
+    makeRaw(*slave);
+    int fd = *master;
+    return std::thread([fd, &frame, numFrames]()
+                       {
+        for (unsigned int ii = 0; ii < numFrames; ii++)
+        {
+            size_t off = 0;
+            while (off < frame.size())
+            {
+                ssize_t n = write(fd, frame.data() + off, frame.size() - off);
+                if (n > 0)
+                    off += n;
+            }
+        } });
+}
+
+/// @brief Waits up to a second for the slave side to have data
+/// @return false if the writer has stalled
+static bool waitForData(int fd)
+{
+    pollfd pfd = {fd, POLLIN, 0};
+    return poll(&pfd, 1, 1000) > 0;
+}
+
+static double runDecoder(const std::vector<uint8_t> &frame, unsigned int numFrames, unsigned int *framesOut)
+{
+    int master, slave;
+    std::thread writer = startWriter(&master, &slave, frame, numFrames);
+
+    LFAST::CobsFrameDecoder<LARGE_MSG_BUFF_SIZE - 1> decoder;
+    unsigned int framesDone = 0;
+    uint8_t chunk[SERIAL_RX_CHUNK_SIZE];
+    auto t0 = std::chrono::steady_clock::now();
+    while (framesDone < numFrames && waitForData(slave))
+    {
+        ssize_t n = read(slave, chunk, sizeof(chunk));
+        if (n <= 0)
+            break;
+        framesDone += decoder.feed(chunk, n, [](const uint8_t *, size_t) {});
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    writer.join();
+    close(master);
+    close(slave);
+
+    *framesOut = framesDone;
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+static double runService(const std::vector<uint8_t> &frame, unsigned int numFrames, unsigned int *framesOut)
+{
+    int master, slave;
+    std::thread writer = startWriter(&master, &slave, frame, numFrames);
+
+    PtyStream stream(slave);
+    BenchService service;
+    service.registerMessageHandler<double>("PMCMessage", "SetTip", countDouble);
+    service.registerMessageHandler<double>("PMCMessage", "SetTilt", countDouble);
+    service.registerMessageHandler<double>("PMCMessage", "SetFocus", countDouble);
+    service.registerMessageHandler<int>("PMCMessage", "MoveType", countInt);
+    service.addSerialLink(stream);
+
+    handlerCalls = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    while (handlerCalls < (unsigned long)numFrames * HANDLERS_PER_MSG)
+    {
+        if (stream.available() <= 0 && !waitForData(slave))
+            break;
+        service.checkForNewClientData();
+        service.processClientData();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    writer.join();
+    close(master);
+    close(slave);
+
+    const LFAST::CommsLinkStats &totals = service.totals();
+    if (totals.droppedFrames > 0 || totals.parseErrors > 0)
+        std::printf("  dropped %lu, parse errors %lu\n", (unsigned long)totals.droppedFrames,
+                    (unsigned long)totals.parseErrors);
+    *framesOut = handlerCalls / HANDLERS_PER_MSG;
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int numFrames = argc > 1 ? std::atoi(argv[1]) : 20000;
+
+    std::vector<uint8_t> frame(LFAST::cobsMaxEncodedLength(std::strlen(sampleMsg)) + 1);
+    size_t frameLen = LFAST::cobsEncode((const uint8_t *)sampleMsg, std::strlen(sampleMsg), frame.data());
+    frame[frameLen++] = 0;
+    frame.resize(frameLen);
+
+    std::printf("%u frames of %zu bytes over a pty pair\n", numFrames, frameLen);
+    unsigned int framesDone = 0;
+    double secs = runDecoder(frame, numFrames, &framesDone);
+    std::printf("decoder only: %8.0f frames/s  %7.2f MB/s  (%u frames)\n",
+                framesDone / secs, framesDone * frameLen / secs / 1e6, framesDone);
+    secs = runService(frame, numFrames, &framesDone);
+    std::printf("service:      %8.0f frames/s  %7.2f MB/s  (%u frames dispatched)\n",
+                framesDone / secs, framesDone * frameLen / secs / 1e6, framesDone);
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file struct_handler_tests.cc
+///
+
+#include "../include/CommService.h"
+
+#include <cstring>
+#include <gtest/gtest.h>
+
+using namespace LFAST;
+
+struct MoveCmd
+{
+    int moveType;
+    double tip;
+    double tilt;
+};
+
+struct FocusCmd
+{
+    double focus;
+    double tip;
+};
+
+static const StructField moveFields[] = {
+    STRUCT_FIELD(MoveCmd, moveType, "MoveType", true),
+    STRUCT_FIELD(MoveCmd, tip, "SetTip", false),
+    STRUCT_FIELD(MoveCmd, tilt, "SetTilt", false)};
+
+static MoveCmd lastMove;
+static uint32_t lastMask = 0;
+static int moves = 0;
+static int tipCalls = 0;
+
+static void onMove(const MoveCmd &cmd, uint32_t presentMask)
+{
+    lastMove = cmd;
+    lastMask = presentMask;
+    moves++;
+}
+static void onFocus(const FocusCmd &, uint32_t) {}
+static void onTip(double) { tipCalls++; }
+
+/// Runs one JSON object through the registry the way dispatchObject() does
+static void dispatch(MessageHandlerRegistry &registry, const char *json)
+{
+    char buff[256];
+    std::strncpy(buff, json, sizeof(buff) - 1);
+    buff[sizeof(buff) - 1] = '\0';
+    StaticJsonDocument<512> doc;
+    ASSERT_FALSE(deserializeJson(doc, buff));
+    for (JsonPair kvp : doc.as<JsonObject>())
+        registry.callMessageHandler(kvp);
+    registry.finishStructs();
+}
+
+class StructHandlerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        moves = 0;
+        tipCalls = 0;
+        lastMask = 0;
+    }
+    MessageHandlerRegistry registry;
+};
+
+TEST_F(StructHandlerTest, testDeliversRecord)
+{
+    ASSERT_TRUE(registry.registerStructHandler<MoveCmd>(moveFields, onMove));
+    dispatch(registry, "{\"MoveType\":2,\"SetTilt\":-0.5}");
+    ASSERT_EQ(moves, 1);
+    EXPECT_EQ(lastMove.moveType, 2);
+    EXPECT_DOUBLE_EQ(lastMove.tip, 0.0);
+    EXPECT_DOUBLE_EQ(lastMove.tilt, -0.5);
+    EXPECT_EQ(lastMask, 0x5U);
+
+    // MoveType is required
+    dispatch(registry, "{\"SetTip\":1.0}");
+    EXPECT_EQ(moves, 1);
+}
+
+TEST_F(StructHandlerTest, testSharedKeyRefused)
+{
+    static const StructField focusFields[] = {
+        STRUCT_FIELD(FocusCmd, focus, "SetFocus", true),
+        STRUCT_FIELD(FocusCmd, tip, "SetTip", false)};
+    ASSERT_TRUE(registry.registerStructHandler<MoveCmd>(moveFields, onMove));
+    EXPECT_FALSE(registry.registerStructHandler<FocusCmd>(focusFields, onFocus));
+
+    // Nothing of the refused schema was registered, and the first one still gets its key
+    dispatch(registry, "{\"MoveType\":1,\"SetTip\":0.25}");
+    ASSERT_EQ(moves, 1);
+    EXPECT_DOUBLE_EQ(lastMove.tip, 0.25);
+    EXPECT_FALSE(registry.registerMessageHandler<double>("SetTip", onTip));
+    EXPECT_TRUE(registry.registerMessageHandler<double>("SetFocus", onTip));
+}
+
+TEST_F(StructHandlerTest, testScalarKeyRefused)
+{
+    ASSERT_TRUE(registry.registerMessageHandler<double>("SetTip", onTip));
+    EXPECT_FALSE(registry.registerStructHandler<MoveCmd>(moveFields, onMove));
+    dispatch(registry, "{\"MoveType\":1,\"SetTip\":0.25}");
+    EXPECT_EQ(tipCalls, 1);
+    EXPECT_EQ(moves, 0);
+}
+
+TEST_F(StructHandlerTest, testRepeatedKeyRefused)
+{
+    static const StructField repeated[] = {
+        STRUCT_FIELD(MoveCmd, tip, "SetTip", false),
+        STRUCT_FIELD(MoveCmd, tilt, "SetTip", false)};
+    EXPECT_FALSE(registry.registerStructHandler<MoveCmd>(repeated, onMove));
+    EXPECT_TRUE(registry.registerStructHandler<MoveCmd>(moveFields, onMove));
+}
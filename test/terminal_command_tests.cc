@@ -0,0 +1,152 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file terminal_command_tests.cc
+///
+
+
+#include "../include/TerminalInterface.h"
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <gtest/gtest.h>
+
+/// Runs a TerminalInterface on pipes: keystrokes go in one, the rendered output comes out the other
+class TerminalCommandTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_EQ(pipe(inPipe), 0);
+        ASSERT_EQ(pipe(outPipe), 0);
+        fcntl(outPipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(outPipe[1], F_SETFL, O_NONBLOCK);
+        port = new HostSerial(inPipe[0], outPipe[1]);
+        cli = new TerminalInterface("TEST", port, 230400);
+        run();
+    }
+    void TearDown() override
+    {
+        delete cli;
+        delete port;
+        for (int fd : {inPipe[0], inPipe[1], outPipe[0], outPipe[1]})
+            close(fd);
+    }
+
+    void type(const std::string &keys)
+    {
+        ASSERT_EQ(write(inPipe[1], keys.data(), keys.size()), (ssize_t)keys.size());
+        run();
+    }
+
+    /// Services the terminal until input is used up and output is drained
+    void run()
+    {
+        char buff[4096];
+        ssize_t len;
+        for (int ii = 0; ii < 1000; ii++)
+        {
+            cli->serviceCLI();
+            while ((len = read(outPipe[0], buff, sizeof(buff))) > 0)
+                output.append(buff, len);
+        }
+    }
+
+    int inPipe[2];
+    int outPipe[2];
+    HostSerial *port;
+    TerminalInterface *cli;
+    std::string output;
+};
+
+static std::string lastArgs;
+static int calls = 0;
+
+static void echoCommand(TerminalInterface *cli, const char *args, void *context)
+{
+    calls++;
+    lastArgs = args;
+    *(int *)context += 1;
+    cli->printfDebugMessage("echo said %s", args);
+}
+
+TEST_F(TerminalCommandTest, testRegisteredCommandGetsArgs)
+{
+    int contextCount = 0;
+    EXPECT_TRUE(cli->registerCommand("echo", "Repeat the arguments", echoCommand, &contextCount));
+    EXPECT_FALSE(cli->registerCommand("echo", "Duplicate", echoCommand, &contextCount));
+
+    output.clear();
+    type("  echo   axis 2\r");
+    EXPECT_EQ(contextCount, 1);
+    EXPECT_EQ(lastArgs, "axis 2");
+    EXPECT_NE(output.find("echo said axis 2"), std::string::npos);
+}
+
+TEST_F(TerminalCommandTest, testUnknownCommand)
+{
+    output.clear();
+    type("bogus 1\r");
+    EXPECT_NE(output.find("bogus: Command Not Found."), std::string::npos);
+
+    // A bare line ending (e.g. the \n of \r\n) isn't a command
+    output.clear();
+    type("\n");
+    EXPECT_EQ(output.find("Command Not Found"), std::string::npos);
+}
+
+TEST_F(TerminalCommandTest, testBuiltins)
+{
+    output.clear();
+    type("help\r");
+    for (const char *name : {"help", "loop", "heap", "zones", "reset"})
+        EXPECT_NE(output.find(name), std::string::npos) << name;
+
+    output.clear();
+    type("loop\r");
+    EXPECT_NE(output.find("Loop: "), std::string::npos);
+    EXPECT_NE(output.find("period min/mean/max"), std::string::npos);
+
+    output.clear();
+    type("heap\r");
+    EXPECT_NE(output.find("bytes in use"), std::string::npos);
+}
+
+static int resets = 0;
+static void countReset(void *) { resets++; }
+
+TEST_F(TerminalCommandTest, testResetRunsHandlers)
+{
+    cli->registerResetHandler(countReset);
+    resets = 0;
+    output.clear();
+    type("reset\r");
+    EXPECT_EQ(resets, 1);
+    EXPECT_NE(output.find("Counters reset"), std::string::npos);
+}
+
+TEST_F(TerminalCommandTest, testFieldFormatIsCopied)
+{
+    LFAST::PersistentFieldHandle field = cli->addPersistentField("TEST", "Value", 0);
+    char fmt[16] = "<%.3f>";
+    cli->updatePersistentField(field, 1.5, fmt);
+    // The caller's buffer is reused before the next repaint
+    std::strcpy(fmt, "%d%d%d%s");
+    output.clear();
+    delay(2 * 1000 / TERMINAL_FRAME_RATE_HZ);
+    run();
+    EXPECT_NE(output.find("<1.500>"), std::string::npos);
+}
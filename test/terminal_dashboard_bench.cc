@@ -0,0 +1,167 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file terminal_dashboard_bench.cc
+///
+/// Runs TerminalInterface on the host serial backend against a synthetic
+/// dashboard: a control loop updating N persistent fields every iteration and
+/// logging M debug messages per second. Output goes to a pseudo-terminal that
+/// a reader thread drains. Reports bytes emitted, write() syscalls and main
+/// thread CPU time, once repainting at loop rate and once at the default frame
+/// rate.
+///
+/// ./terminal_dashboard_bench [numFields] [msgsPerSec] [seconds] [loopHz]
+
+#include "../include/TerminalInterface.h"
+
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+struct BenchConfig
+{
+    unsigned int numFields;
+    unsigned int msgsPerSec;
+    double seconds;
+    unsigned int loopHz;
+};
+
+struct BenchResult
+{
+    uint64_t bytes;
+    uint64_t writeCalls;
+    uint64_t loops;
+    double cpuSec;
+};
+
+static double threadCpuSeconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static BenchResult runDashboard(const BenchConfig &cfg, uint32_t frameRateHz)
+{
+    int master, slave;
+    if (openpty(&master, &slave, nullptr, nullptr, nullptr) != 0)
+    {
+        perror("openpty");
+        std::exit(1);
+    }
+    termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    std::atomic<bool> done(false);
+    std::thread reader([&]() {
+        char buff[4096];
+        while (!done.load())
+        {
+            pollfd pfd = {slave, POLLIN, 0};
+            if (poll(&pfd, 1, 10) > 0 && ::read(slave, buff, sizeof(buff)) <= 0)
+                break;
+        }
+    });
+
+    HostSerial port(-1, master);
+    BenchResult result = {};
+    {
+        TerminalInterface cli("DASHBOARD BENCH", &port, 230400);
+        cli.setFrameRate(frameRateHz);
+        cli.registerDevice("Bench");
+        std::vector<LFAST::PersistentFieldHandle> fields;
+        char label[24];
+        for (unsigned int ii = 0; ii < cfg.numFields; ii++)
+        {
+            snprintf(label, sizeof(label), "[FIELD %u]", ii);
+            fields.push_back(cli.addPersistentField("Bench", label, ii));
+        }
+        cli.printPersistentFieldLabels();
+        // Let the header and labels go out before measuring
+        while (cli.pendingOutput() > 0)
+            cli.serviceCLI();
+
+        uint64_t bytesBefore = port.bytesWritten;
+        uint64_t callsBefore = port.writeCalls;
+        double cpuBefore = threadCpuSeconds();
+
+        auto period = std::chrono::nanoseconds(1000000000ULL / cfg.loopHz);
+        uint64_t numLoops = (uint64_t)(cfg.seconds * cfg.loopHz);
+        uint64_t loopsPerMsg = (cfg.msgsPerSec > 0) ? cfg.loopHz / cfg.msgsPerSec : 0;
+        auto next = std::chrono::steady_clock::now();
+        for (uint64_t loop = 0; loop < numLoops; loop++)
+        {
+            for (unsigned int ii = 0; ii < cfg.numFields; ii++)
+                cli.updatePersistentField(fields[ii], 0.001 * (double)(loop + ii));
+            if (loopsPerMsg > 0 && loop % loopsPerMsg == 0)
+                cli.printfDebugMessage("Loop %lu: setpoint reached", (unsigned long)loop);
+            cli.serviceCLI();
+
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+
+        result.cpuSec = threadCpuSeconds() - cpuBefore;
+        result.bytes = port.bytesWritten - bytesBefore;
+        result.writeCalls = port.writeCalls - callsBefore;
+        result.loops = numLoops;
+    }
+
+    done = true;
+    reader.join();
+    close(master);
+    close(slave);
+    return result;
+}
+
+static void printResult(const char *name, const BenchConfig &cfg, const BenchResult &r, double frames)
+{
+    std::printf("%-12s %12.0f %10.0f %12.1f %12.2f %10.1f\n", name,
+                r.bytes / cfg.seconds, r.writeCalls / cfg.seconds,
+                r.bytes / frames, r.writeCalls / frames,
+                1e6 * r.cpuSec / r.loops);
+}
+
+int main(int argc, char **argv)
+{
+    BenchConfig cfg;
+    cfg.numFields = (argc > 1) ? std::atoi(argv[1]) : 24;
+    cfg.msgsPerSec = (argc > 2) ? std::atoi(argv[2]) : 20;
+    cfg.seconds = (argc > 3) ? std::atof(argv[3]) : 2.0;
+    cfg.loopHz = (argc > 4) ? std::atoi(argv[4]) : 1000;
+
+    std::printf("%u fields, %u debug msgs/s, %u Hz loop, %.1f s per run\n",
+                cfg.numFields, cfg.msgsPerSec, cfg.loopHz, cfg.seconds);
+    std::printf("%-12s %12s %10s %12s %12s %10s\n", "repaint", "bytes/s", "writes/s", "bytes/frame", "writes/frame", "cpu us/loop");
+
+    // A "frame" is one repaint opportunity: every loop when repainting at loop rate
+    BenchResult loopRate = runDashboard(cfg, 0);
+    printResult("loop rate", cfg, loopRate, (double)loopRate.loops);
+
+    BenchResult frameRate = runDashboard(cfg, TERMINAL_FRAME_RATE_HZ);
+    char name[16];
+    snprintf(name, sizeof(name), "%u Hz", TERMINAL_FRAME_RATE_HZ);
+    printResult(name, cfg, frameRate, cfg.seconds * TERMINAL_FRAME_RATE_HZ);
+    return 0;
+}
@@ -0,0 +1,76 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file terminal_format_tests.cc
+///
+
+
+#include "../include/TerminalFormat.h"
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <gtest/gtest.h>
+
+using namespace LFAST;
+
+// How printDebugMessage built its lines before it stopped allocating
+static std::string streamDebugLine(uint16_t count, unsigned long ms, const std::string &color, const std::string &msg)
+{
+    std::stringstream ss;
+    ss << std::setiosflags(std::ios::left) << std::setw(12);
+    ss << "\033[37m" << count << "[" << ms << "]: " << color << msg;
+    return ss.str();
+}
+
+TEST(terminal_format_tests, testMatchesStreamOutput)
+{
+    char line[160];
+    const unsigned long times[] = {0, 7, 123456, 4294967295UL};
+    const char *colors[] = {"\033[37m", "\033[32m", "\033[33m", "\033[31m"};
+    const char *msgs[] = {"", "Connection # 1 Made.", "Invalid Message: {\"a\":}"};
+    uint16_t count = 1;
+    for (unsigned long ms : times)
+        for (const char *color : colors)
+            for (const char *msg : msgs)
+            {
+                size_t len = formatDebugLine(line, sizeof(line), count, ms, color, msg);
+                std::string expected = streamDebugLine(count, ms, color, msg);
+                EXPECT_EQ(std::string(line, len), expected);
+                count = count * 7 + 3;
+            }
+}
+
+TEST(terminal_format_tests, testLineBreaksAndTruncation)
+{
+    char line[32];
+    size_t len = formatDebugLine(line, sizeof(line), 5, 10, "\033[37m", "Made.\r\nthis part gets cut off");
+    EXPECT_EQ(len, sizeof(line) - 1);
+    EXPECT_EQ(std::string(line), std::string("\033[37m       5[10]: \033[37mMade.  ").substr(0, 31));
+}
+
+TEST(terminal_format_tests, testDebugCodeId)
+{
+    EXPECT_STREQ(DebugCodeId("/home/user/lfast/src/CommService.cc", 42).c_str(), "CommService.cc[42]");
+    EXPECT_STREQ(DebugCodeId("main.cpp", 7).c_str(), "main.cpp[7]");
+}
+
+TEST(terminal_format_tests, testDebugCodeIdStr)
+{
+    // Still a std::string, so it can be kept and concatenated
+    std::string id = DEBUG_CODE_ID_STR; std::string expected = "terminal_format_tests.cc[" + std::to_string(__LINE__) + "]";
+    EXPECT_EQ(id, expected);
+    EXPECT_EQ(DEBUG_CODE_ID_STR + ": x", "terminal_format_tests.cc[" + std::to_string(__LINE__) + "]: x");
+    EXPECT_STREQ(DEBUG_CODE_ID.c_str(), ("terminal_format_tests.cc[" + std::to_string(__LINE__) + "]").c_str());
+}
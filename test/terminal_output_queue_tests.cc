@@ -0,0 +1,114 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file terminal_output_queue_tests.cc
+///
+
+
+#include "../include/TerminalOutputQueue.h"
+#include <string>
+#include <gtest/gtest.h>
+
+using namespace LFAST;
+
+/// Accepts at most `room` bytes per write, like a serial port with a small TX buffer
+class LimitedOutput : public TerminalOutput
+{
+public:
+    size_t write(const char *data, size_t len) override
+    {
+        if (len > room)
+            len = room;
+        text.append(data, len);
+        return len;
+    }
+    size_t room = 1000;
+    std::string text;
+};
+
+TEST(terminal_output_queue_tests, testDrainBudget)
+{
+    TerminalOutputQueue queue(64);
+    LimitedOutput out;
+    queue.write("0123456789", 10);
+    EXPECT_EQ(queue.drain(out, 4), 4U);
+    EXPECT_EQ(out.text, "0123");
+    EXPECT_EQ(queue.pending(), 6U);
+    EXPECT_EQ(queue.drain(out, 100), 6U);
+    EXPECT_EQ(out.text, "0123456789");
+    EXPECT_EQ(queue.drain(out, 100), 0U);
+}
+
+TEST(terminal_output_queue_tests, testSinkBackpressure)
+{
+    TerminalOutputQueue queue(64);
+    LimitedOutput out;
+    out.room = 3;
+    queue.write("abcdefgh", 8);
+    EXPECT_EQ(queue.drain(out, 100), 3U);
+    EXPECT_EQ(queue.pending(), 5U);
+    out.room = 1000;
+    queue.drain(out, 100);
+    EXPECT_EQ(out.text, "abcdefgh");
+}
+
+TEST(terminal_output_queue_tests, testWrapAround)
+{
+    TerminalOutputQueue queue(8);
+    LimitedOutput out;
+    queue.write("abcdef", 6);
+    queue.drain(out, 5);
+    // Head wraps past the end of the ring here
+    EXPECT_EQ(queue.write("ghijkl", 6), 6U);
+    EXPECT_EQ(queue.pending(), 7U);
+    queue.drain(out, 100);
+    EXPECT_EQ(out.text, "abcdefghijkl");
+}
+
+TEST(terminal_output_queue_tests, testOverflowDropsWholeWrite)
+{
+    TerminalOutputQueue queue(8);
+    LimitedOutput out;
+    EXPECT_EQ(queue.write("\033[2;1H", 6), 6U);
+    EXPECT_EQ(queue.write("\033[0K", 4), 0U);
+    EXPECT_EQ(queue.droppedBytes(), 4U);
+    EXPECT_EQ(queue.pending(), 6U);
+    queue.drain(out, 100);
+    EXPECT_EQ(out.text, "\033[2;1H");
+}
+
+TEST(terminal_output_queue_tests, testSequenceDroppedAsUnit)
+{
+    TerminalOutputQueue queue(16);
+    LimitedOutput out;
+    queue.write("abcdef", 6);
+    queue.drain(out, 4);
+
+    // The cursor move fits but its text doesn't, so neither is sent
+    queue.beginSequence();
+    EXPECT_EQ(queue.write("\033[2;1H", 6), 6U);
+    EXPECT_EQ(queue.write("0123456789", 10), 0U);
+    EXPECT_EQ(queue.write("\033[0K", 4), 0U);
+    EXPECT_FALSE(queue.endSequence());
+    EXPECT_EQ(queue.pending(), 2U);
+    EXPECT_EQ(queue.droppedBytes(), 20U);
+
+    queue.beginSequence();
+    queue.write("\033[3;1H", 6);
+    queue.write("xyz", 3);
+    EXPECT_TRUE(queue.endSequence());
+    queue.drain(out, 100);
+    EXPECT_EQ(out.text, "abcdef\033[3;1Hxyz");
+}
@@ -0,0 +1,141 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file terminal_screen_tests.cc
+///
+
+#include "../include/TerminalScreenBuffer.h"
+#include <string>
+#include <gtest/gtest.h>
+
+using namespace LFAST;
+
+class StringOutput : public TerminalOutput
+{
+public:
+    size_t write(const char *data, size_t len) override
+    {
+        text.append(data, len);
+        return len;
+    }
+    std::string take()
+    {
+        std::string out;
+        out.swap(text);
+        return out;
+    }
+    std::string text;
+};
+
+TEST(terminal_screen_tests, testFirstFlushSendsText)
+{
+    TerminalScreenBuffer screen(4, 40);
+    StringOutput out;
+    screen.put(1, 10, "12.5");
+    size_t sent = screen.flush(out);
+    EXPECT_EQ(sent, out.text.size());
+    EXPECT_EQ(out.take(), "\033[2;11H12.5");
+}
+
+TEST(terminal_screen_tests, testUnchangedValueSendsNothing)
+{
+    TerminalScreenBuffer screen(4, 40);
+    StringOutput out;
+    screen.put(1, 10, "12.5");
+    screen.flush(out);
+    out.take();
+
+    screen.put(1, 10, "12.5");
+    EXPECT_EQ(screen.flush(out), 0U);
+    EXPECT_EQ(out.take(), "");
+}
+
+TEST(terminal_screen_tests, testOnlyChangedCharsSent)
+{
+    TerminalScreenBuffer screen(4, 40);
+    StringOutput out;
+    screen.put(2, 0, "Position: 100.0001");
+    screen.flush(out);
+    out.take();
+
+    screen.put(2, 0, "Position: 100.0002");
+    screen.flush(out);
+    EXPECT_EQ(out.take(), "\033[3;18H2");
+}
+
+TEST(terminal_screen_tests, testShorterValueErasesTail)
+{
+    TerminalScreenBuffer screen(4, 40);
+    StringOutput out;
+    screen.put(0, 5, "123456");
+    screen.flush(out);
+    out.take();
+
+    screen.put(0, 5, "12");
+    screen.flush(out);
+    EXPECT_EQ(out.take(), "\033[1;8H\033[0K");
+    EXPECT_EQ(screen.at(0, 7), ' ');
+}
+
+TEST(terminal_screen_tests, testNearbyChangesShareOneMove)
+{
+    TerminalScreenBuffer screen(2, 40);
+    StringOutput out;
+    screen.put(0, 0, "a=1 b=2 c=3");
+    screen.flush(out);
+    out.take();
+
+    // Changes 4 columns apart are cheaper to resend than to skip with a second cursor move
+    screen.put(0, 0, "a=5 b=6 c=3");
+    screen.flush(out);
+    EXPECT_EQ(out.take(), "\033[1;3H5 b=6");
+}
+
+TEST(terminal_screen_tests, testPrefixOnlyWhenSomethingChanged)
+{
+    TerminalScreenBuffer screen(2, 20);
+    StringOutput out;
+    screen.put(0, 0, "x");
+    screen.flush(out, "\033[37m");
+    EXPECT_EQ(out.take(), "\033[37m\033[1;1Hx");
+
+    screen.put(0, 0, "x");
+    screen.flush(out, "\033[37m");
+    EXPECT_EQ(out.take(), "");
+}
+
+TEST(terminal_screen_tests, testMarkClearedRepaints)
+{
+    TerminalScreenBuffer screen(2, 20);
+    StringOutput out;
+    screen.put(1, 0, "label:");
+    screen.flush(out);
+    out.take();
+
+    screen.markCleared();
+    screen.flush(out);
+    EXPECT_EQ(out.take(), "\033[2;1Hlabel:");
+}
+
+TEST(terminal_screen_tests, testClipsAtRightEdge)
+{
+    TerminalScreenBuffer screen(1, 8);
+    StringOutput out;
+    screen.put(0, 4, "abcdefgh");
+    screen.flush(out);
+    EXPECT_EQ(out.take(), "\033[1;5Habcd");
+    screen.put(5, 0, "off screen");
+    EXPECT_FALSE(screen.dirty());
+}
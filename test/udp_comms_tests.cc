@@ -0,0 +1,342 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file udp_comms_tests.cc
+///
+/// Drives UdpCommsService over loopback sockets (see host/EthernetUdp.h).
+/// The target is built with a short UDP_PEER_IDLE_TIMEOUT_MS.
+///
+
+#include "../include/UdpCommsService.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+class TestUdpService : public LFAST::UdpCommsService
+{
+public:
+    TestUdpService() : LFAST::UdpCommsService(localhost) {}
+    uint16_t port() { return udp.localPort(); }
+    unsigned int numPeers()
+    {
+        unsigned int count = 0;
+        for (auto &conn : connections)
+            count += conn.isDatagramPeer() ? 1 : 0;
+        return count;
+    }
+    /// Connections are shared by every service, so each test starts from an empty table
+    static void clearConnections()
+    {
+        for (auto &conn : connections)
+            for (auto msg : conn.rxMessageQueue)
+                delete msg;
+        connections.clear();
+    }
+    static void disconnectTerminal() { cli = nullptr; }
+    std::vector<uint16_t> peerIds()
+    {
+        std::vector<uint16_t> ids;
+        for (auto &conn : connections)
+            ids.push_back(conn.id);
+        return ids;
+    }
+
+private:
+    static byte localhost[4];
+};
+byte TestUdpService::localhost[4] = {127, 0, 0, 1};
+
+/// An ordinary UDP socket standing in for a remote client
+class TestPeer
+{
+public:
+    TestPeer(uint16_t _servicePort) : servicePort(_servicePort)
+    {
+        sock = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(sock, (sockaddr *)&addr, sizeof(addr));
+    }
+    ~TestPeer() { close(sock); }
+
+    void send(const std::string &datagram)
+    {
+        sockaddr_in to{};
+        to.sin_family = AF_INET;
+        to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        to.sin_port = htons(servicePort);
+        ASSERT_EQ(sendto(sock, datagram.data(), datagram.size(), 0, (sockaddr *)&to, sizeof(to)), (ssize_t)datagram.size());
+    }
+
+    /// @return the next datagram sent to this peer, or "" if none arrives within a second
+    std::string receive()
+    {
+        pollfd pfd = {sock, POLLIN, 0};
+        if (poll(&pfd, 1, 1000) <= 0)
+            return "";
+        char buff[2048];
+        ssize_t len = recv(sock, buff, sizeof(buff), 0);
+        return (len > 0) ? std::string(buff, len) : "";
+    }
+
+private:
+    int sock;
+    uint16_t servicePort;
+};
+
+static std::vector<double> tipValues;
+static std::vector<double> focusValues;
+static TestUdpService *activeService = nullptr;
+static size_t replyDocSize = 0;
+
+static void setTip(double val)
+{
+    tipValues.push_back(val);
+}
+
+static void setFocus(double val)
+{
+    focusValues.push_back(val);
+}
+
+static void ping(int val)
+{
+    LFAST::SmallCommsMessage reply;
+    reply.addKeyValuePair<int>("Pong", val);
+    activeService->sendMessage(reply, LFAST::CommsService::ACTIVE_CONNECTION);
+    replyDocSize = reply.getJsonDoc().as<JsonObject>().size();
+}
+
+class UdpCommsTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        TestUdpService::clearConnections();
+        tipValues.clear();
+        focusValues.clear();
+        ASSERT_TRUE(service.initializeUdpIface(0));
+        service.registerMessageHandler<double>("SetTip", setTip);
+        service.registerMessageHandler<double>("SetFocus", setFocus);
+        service.registerMessageHandler<int>("Ping", ping);
+        activeService = &service;
+    }
+    void TearDown() override
+    {
+        activeService = nullptr;
+        TestUdpService::clearConnections();
+    }
+
+    /// Sends a sequenced setpoint from a peer
+    void sendTip(TestPeer &peer, uint32_t seq, double tip)
+    {
+        peer.send("{\"Seq\":" + std::to_string(seq) + ",\"SetTip\":" + std::to_string(tip) + "}");
+    }
+
+    void run()
+    {
+        service.checkForNewClientData();
+        service.processClientData();
+    }
+
+    TestUdpService service;
+};
+
+TEST_F(UdpCommsTest, testLatestWinsDropsStale)
+{
+    TestPeer peer(service.port());
+    sendTip(peer, 1, 1.0);
+    sendTip(peer, 3, 3.0);
+    sendTip(peer, 2, 2.0);
+    run();
+    ASSERT_EQ(tipValues.size(), 1U);
+    EXPECT_DOUBLE_EQ(tipValues[0], 3.0);
+
+    // Unsequenced messages are all delivered, in order
+    peer.send("{\"SetTip\":4.0}");
+    peer.send("{\"SetTip\":5.0}");
+    run();
+    ASSERT_EQ(tipValues.size(), 3U);
+    EXPECT_DOUBLE_EQ(tipValues[2], 5.0);
+}
+
+TEST_F(UdpCommsTest, testLatestWinsIsPerKey)
+{
+    TestPeer peer(service.port());
+    peer.send("{\"Seq\":1,\"SetTip\":1.0,\"SetFocus\":10.0}");
+    peer.send("{\"Seq\":2,\"SetFocus\":20.0}");
+    run();
+    // The newer datagram only replaces the focus; the tip still gets through
+    ASSERT_EQ(tipValues.size(), 1U);
+    EXPECT_DOUBLE_EQ(tipValues[0], 1.0);
+    ASSERT_EQ(focusValues.size(), 1U);
+    EXPECT_DOUBLE_EQ(focusValues[0], 20.0);
+}
+
+TEST_F(UdpCommsTest, testLargeBackwardsJumpResyncs)
+{
+    TestPeer peer(service.port());
+    sendTip(peer, 1000, 1.0);
+    run();
+    // A little behind is a reordered datagram
+    sendTip(peer, 1000 - UDP_SEQ_RESYNC_WINDOW, 2.0);
+    run();
+    ASSERT_EQ(tipValues.size(), 1U);
+    // Far behind is a restarted sender
+    sendTip(peer, 5, 3.0);
+    run();
+    sendTip(peer, 6, 4.0);
+    run();
+    ASSERT_EQ(tipValues.size(), 3U);
+    EXPECT_DOUBLE_EQ(tipValues[1], 3.0);
+    EXPECT_DOUBLE_EQ(tipValues[2], 4.0);
+}
+
+TEST_F(UdpCommsTest, testIdlePeerResyncs)
+{
+    TestPeer peer(service.port());
+    sendTip(peer, 500, 1.0);
+    run();
+    sendTip(peer, 499, 2.0);
+    run();
+    ASSERT_EQ(tipValues.size(), 1U);
+
+    delay(UDP_PEER_IDLE_TIMEOUT_MS + 50);
+    sendTip(peer, 499, 3.0);
+    run();
+    ASSERT_EQ(tipValues.size(), 2U);
+    EXPECT_DOUBLE_EQ(tipValues[1], 3.0);
+}
+
+TEST_F(UdpCommsTest, testPeerTableEvictsIdlePeers)
+{
+    std::vector<TestPeer *> peers;
+    for (unsigned int ii = 0; ii < MAX_UDP_PEERS; ii++)
+    {
+        peers.push_back(new TestPeer(service.port()));
+        sendTip(*peers.back(), 10, ii);
+    }
+    run();
+    EXPECT_EQ(service.numPeers(), (unsigned int)MAX_UDP_PEERS);
+    ASSERT_EQ(tipValues.size(), (size_t)MAX_UDP_PEERS);
+    std::vector<uint16_t> idsBefore = service.peerIds();
+
+    // Every peer is active, so a new one is turned away
+    TestPeer newcomer(service.port());
+    sendTip(newcomer, 1, 100.0);
+    run();
+    EXPECT_EQ(tipValues.size(), (size_t)MAX_UDP_PEERS);
+
+    // Once the others go quiet, the newcomer takes the least recently heard slot
+    delay(UDP_PEER_IDLE_TIMEOUT_MS / 2);
+    sendTip(*peers[0], 11, 11.0);
+    run();
+    delay(UDP_PEER_IDLE_TIMEOUT_MS / 2 + 50);
+    sendTip(*peers[0], 12, 12.0);
+    sendTip(newcomer, 2, 200.0);
+    run();
+    EXPECT_EQ(service.numPeers(), (unsigned int)MAX_UDP_PEERS);
+    ASSERT_EQ(tipValues.size(), (size_t)MAX_UDP_PEERS + 3);
+    EXPECT_DOUBLE_EQ(tipValues.back(), 200.0);
+
+    // The replaced slot is a new connection as far as captures are concerned
+    std::vector<uint16_t> idsAfter = service.peerIds();
+    ASSERT_EQ(idsAfter.size(), idsBefore.size());
+    unsigned int changed = 0;
+    for (size_t ii = 0; ii < idsAfter.size(); ii++)
+    {
+        if (idsAfter[ii] != idsBefore[ii])
+        {
+            changed++;
+            EXPECT_GT(idsAfter[ii], idsBefore.back());
+        }
+    }
+    EXPECT_EQ(changed, 1U);
+    EXPECT_EQ(idsAfter[0], idsBefore[0]);
+
+    // peers[0] kept its slot and its sequence state
+    sendTip(*peers[0], 11, 13.0);
+    run();
+    EXPECT_EQ(tipValues.size(), (size_t)MAX_UDP_PEERS + 3);
+
+    for (auto peer : peers)
+        delete peer;
+}
+
+TEST_F(UdpCommsTest, testReplyGoesBackToSender)
+{
+    TestPeer peer(service.port());
+    peer.send("{\"Ping\":7}");
+    run();
+    EXPECT_EQ(peer.receive(), "{\"Seq\":0,\"Pong\":7}");
+    EXPECT_EQ(replyDocSize, 1u); // no Seq left in the sent document
+    peer.send("{\"Ping\":8}");
+    run();
+    EXPECT_EQ(peer.receive(), "{\"Seq\":1,\"Pong\":8}");
+    EXPECT_EQ(replyDocSize, 1u); // no Seq left in the sent document
+}
+
+TEST_F(UdpCommsTest, testMsgPackReplyCarriesSeq)
+{
+    TestPeer peer(service.port());
+    peer.send(std::string("\x81\xa4Ping\x07", 7));
+    run();
+    EXPECT_EQ(peer.receive(), std::string("\x82\xa3Seq\xce\x00\x00\x00\x00\xa4Pong\x07", 16));
+    EXPECT_EQ(replyDocSize, 1u); // no Seq left in the sent document
+}
+
+TEST_F(UdpCommsTest, testProcessedRowShowsEarlyParsedMessage)
+{
+    // A terminal on a pipe, to see what the comms rows show
+    int outPipe[2];
+    ASSERT_EQ(pipe(outPipe), 0);
+    fcntl(outPipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(outPipe[1], F_SETFL, O_NONBLOCK);
+    HostSerial port(-1, outPipe[1]);
+    TerminalInterface *cli = new TerminalInterface("TEST", &port, 230400);
+    service.connectTerminalInterface(cli, "UDP");
+
+    // The sequence check parses this as it arrives, long before it is processed
+    TestPeer peer(service.port());
+    sendTip(peer, 1, 3.0);
+    run();
+    ASSERT_EQ(tipValues.size(), 1U);
+
+    std::string output;
+    char buff[4096];
+    ssize_t len;
+    delay(2 * 1000 / TERMINAL_FRAME_RATE_HZ);
+    for (int ii = 0; ii < 1000; ii++)
+    {
+        cli->serviceCLI();
+        while ((len = read(outPipe[0], buff, sizeof(buff))) > 0)
+            output.append(buff, len);
+    }
+    EXPECT_NE(output.find("{\"SetTip\":3}"), std::string::npos);
+
+    TestUdpService::disconnectTerminal();
+    delete cli;
+    close(outPipe[0]);
+    close(outPipe[1]);
+}
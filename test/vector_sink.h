@@ -0,0 +1,42 @@
+/*******************************************************************************
+Copyright 2022
+Steward Observatory Engineering & Technical Services, University of Arizona
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or any later version.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <https://www.gnu.org/licenses/>.
+*******************************************************************************/
+///
+/// @author Kevin Gilliam
+/// @date February 16th, 2023
+/// @file vector_sink.h
+/// @brief CaptureSink that keeps everything written to it in memory, for tests
+///
+
+#pragma once
+
+#include "../include/FrameCapture.h"
+
+#include <vector>
+
+class VectorSink : public LFAST::CaptureSink
+{
+public:
+    bool write(const uint8_t *data, size_t len) override
+    {
+        if (failWrites)
+            return false;
+        writeSizes.push_back(len);
+        bytes.insert(bytes.end(), data, data + len);
+        return true;
+    }
+    // Set to make every write fail, as a full or missing card would
+    bool failWrites = false;
+    std::vector<uint8_t> bytes;
+    // Size of each accepted write, in order
+    std::vector<size_t> writeSizes;
+};